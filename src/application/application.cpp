@@ -24,6 +24,7 @@ void Application::start(int argc, const char** argv) {
 
   std::string file_path;
   std::string project_path;
+  int pid = 0;
   try
   {
     desc.add_options()
@@ -31,7 +32,9 @@ void Application::start(int argc, const char** argv) {
       ("file", po::value<std::string>(&file_path)->default_value("hexx0ar"),
        "path to the file the hex editor loads")
       ("project", po::value<std::string>(&project_path)->default_value("project.json"),
-       "path to the configuration file storing the hexviews");
+       "path to the configuration file storing the hexviews")
+      ("pid", po::value<int>(&pid),
+       "id of a local process whose memory is shown instead of a file");
 
     store(parse_command_line(argc, argv, desc), vm);
     po::notify(vm);
@@ -79,7 +82,11 @@ void Application::start(int argc, const char** argv) {
   hexedit.ReadOnly = true;
   hexedit.OptShowAscii = false;
 
-  hexedit.LoadFile(file_path.c_str());
+  // returns right away, the file is shown as soon as the loader opened it
+  if (pid > 0)
+    hexedit.AttachProcess(pid);
+  else
+    hexedit.LoadFile(file_path.c_str());
   hexedit.project_path = project_path;
 
   while(m_running) {
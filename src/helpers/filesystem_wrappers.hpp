@@ -14,26 +14,28 @@ namespace io {
  * function // lambda for every found file/directory fitting in the pattern scheme.
  *
  * @param src path to the source directory
- * @param pattern the extension pattern other files are searched for
- * @param func the lambda or function being called when a directory is found
+ * @param pattern the extension pattern other files are searched for (with the dot), empty for every file
+ * @param func the lambda or function being called when a file is found
  * */
-void iterateFiles(fs::path src, std::string pattern, std::function<void(fs::path path)> func) {
+inline void iterateFiles(fs::path src, std::string pattern, std::function<void(fs::path path)> func) {
 
-  if ( !fs::exists( src ) || !fs::is_directory(src))
+  // unreadable directories (EACCES, ...) are reported through the error code instead of throwing
+  boost::system::error_code ec;
+  if ( !fs::exists( src, ec ) || !fs::is_directory(src, ec))
   {
     LOG_WARN("Didn't found source directory or it's not a directory: " + src.string())
     return;
   }
   fs::directory_iterator end_iter;
-  for ( fs::directory_iterator dir_itr( src );
-        dir_itr != end_iter;
-        ++dir_itr )
+  for ( fs::directory_iterator dir_itr( src, ec );
+        !ec && dir_itr != end_iter;
+        dir_itr.increment(ec) )
   {
     try
     {
       if ( fs::is_regular_file( dir_itr->status() ) )
       {
-        if( dir_itr->path().extension().compare(pattern) == 0) {
+        if( pattern.empty() || dir_itr->path().extension().compare(pattern) == 0) {
           func(dir_itr->path());
         }
       }
@@ -43,6 +45,8 @@ void iterateFiles(fs::path src, std::string pattern, std::function<void(fs::path
       LOG_ERROR(dir_itr->path().string() + " " + e.what())
     }
   }
+  if ( ec )
+    LOG_ERROR("couldn't read " + src.string() + ": " + ec.message())
 
 }
 
@@ -54,17 +58,19 @@ void iterateFiles(fs::path src, std::string pattern, std::function<void(fs::path
  * @param pattern the extension pattern other directories are searched for
  * @param func the lambda or function being called when a directory is found
  * */
-void iterateDirectory(fs::path src, std::string pattern, std::function<void(fs::path path)> func) {
+inline void iterateDirectory(fs::path src, std::string pattern, std::function<void(fs::path path)> func) {
 
-  if ( !fs::exists( src ) || !fs::is_directory(src))
+  // unreadable directories (EACCES, ...) are reported through the error code instead of throwing
+  boost::system::error_code ec;
+  if ( !fs::exists( src, ec ) || !fs::is_directory(src, ec))
   {
     LOG_WARN("Didn't found source directory or it's not a directory: " + src.string())
     return;
   }
   fs::directory_iterator end_iter;
-  for ( fs::directory_iterator dir_itr( src );
-        dir_itr != end_iter;
-        ++dir_itr )
+  for ( fs::directory_iterator dir_itr( src, ec );
+        !ec && dir_itr != end_iter;
+        dir_itr.increment(ec) )
   {
     try
     {
@@ -80,6 +86,8 @@ void iterateDirectory(fs::path src, std::string pattern, std::function<void(fs::
       LOG_ERROR(dir_itr->path().string() + " " + e.what())
     }
   }
+  if ( ec )
+    LOG_ERROR("couldn't read " + src.string() + ": " + ec.message())
 
 }
 
@@ -2,66 +2,137 @@
 #include <boost/filesystem/operations.hpp>
 #include <application/log.hpp>
 #include <algorithm>
+#include <cmath>
+#include <inttypes.h>
 #include <SDL2/SDL_video.h>
 #include "hexedit.hpp"
+#include "io/save.hpp"
+#include "io/processsource.hpp"
+#include "io/firmware.hpp"
+#include "io/snapshot.hpp"
+#include "search/scanner.hpp"
+#include "search/signatures.hpp"
 
 namespace fs = boost::filesystem;
 
-void to_json(json& j, const HexView& v) {
-  j = json{{"name", v.name},
-           {"start", v.start},
-           {"end", v.end},
-           {"color_r", v.color.x},
-           {"color_g", v.color.y},
-           {"color_b", v.color.z},
-           {"color_a", v.color.w}};
-}
+const size_t HexEdit::WindowRows;
+const size_t HexEdit::MaxSearchViews;
+const size_t HexEdit::HighlightBatch;
 
-void from_json(const json& j, HexView& v) {
-  std::string name = j.at("name").get<std::string>();
-  if(name.size() > sizeof(v.name)-1)
-    name.resize(sizeof(v.name)-1);
-  strcpy(v.name, name.data());
+int HexEdit::ViewAt(size_t addr) {
+  UpdateViewIndex();
+  return (int)m_view_index.innermost(addr);
+}
 
-  v.start = j.at("start").get<size_t>();
-  v.end = j.at("end").get<size_t>();
+void HexEdit::UpdateViewIndex() {
+  if(m_view_index_version == m_views.version())
+    return;
+  m_view_index.clear();
+  for(size_t i = 0; i < m_views.size(); i++)
+    m_view_index.add(m_views.start(i), m_views.end(i), (uint32_t)i);
+  m_view_index.build();
+  m_view_index_version = m_views.version();
+}
 
-  v.color.x = j.at("color_r").get<float>();
-  v.color.y = j.at("color_g").get<float>();
-  v.color.z = j.at("color_b").get<float>();
-  v.color.w = j.at("color_a").get<float>();
+uint32_t HexEdit::ViewAround(size_t start, size_t end) {
+  int i = ViewAt(start);
+  while (i >= 0 && m_views.end(i) < end) {
+    const uint32_t parent = m_views.parent(i);
+    i = parent == ViewStore::NoView ? -1 : (int)m_views.indexOf(parent);
+  }
+  return i < 0 ? ViewStore::NoView : m_views.id(i);
 }
 
-size_t HexEdit::getRow(size_t addr) {
-  return (size_t)(addr/Columns);
+uint64_t HexEdit::AddrOf(size_t off) const {
+  return m_segments.empty() ? base_display_addr + off : m_segments.addressOf(off);
 }
 
-size_t HexEdit::getCol(size_t addr) {
-  return addr%Columns;
+bool HexEdit::OffsetOf(uint64_t addr, size_t& off) const {
+  if(!m_segments.empty())
+    return m_segments.offsetOf(addr, off);
+
+  if(addr < base_display_addr) {
+    off = 0;
+    return false;
+  }
+  off = (size_t)(addr - base_display_addr);
+  return off < mem_size;
 }
 
-float HexEdit::getTopX(size_t addr) {
-  return HexCellWidth*getCol(addr) + (0.5f*GlyphWidth)*((size_t)(getCol(addr)/8));
+uint64_t HexEdit::MaxAddr() const {
+  if(!m_segments.empty())
+    return m_segments.maxAddress();
+  return base_display_addr + (mem_size ? mem_size - 1 : 0);
 }
 
-float HexEdit::getTopY(size_t addr) {
-  return LineHeight*getRow(addr);
+size_t HexEdit::RowCount() const {
+  return (mem_size + Columns - 1) / Columns;
 }
 
-float HexEdit::getBottomX(size_t addr) {
-  return getTopX(addr)+(2*GlyphWidth);
+void HexEdit::ScrollToRow(size_t row, float pixel_offset) {
+  const size_t total = RowCount();
+  size_t base = 0;
+  if (total > WindowRows)
+    base = std::min(row - std::min(row, WindowRows / 2), total - WindowRows);
+
+  // both change in the next frame, when imgui applies the scroll position
+  m_pending_base = base;
+  ImGui::SetScrollY((float)(row - base) * LineHeight + pixel_offset);
 }
-float HexEdit::getBottomY(size_t addr) {
-  return getTopY(addr)+LineHeight;
+
+bool HexEdit::DrawScrollbar(float height, size_t total, size_t top_row, size_t visible_rows, float& grab,
+                            size_t& row) {
+  ImGuiStyle& style = ImGui::GetStyle();
+  ImDrawList* draw_list = ImGui::GetWindowDrawList();
+  const ImVec2 pos = ImGui::GetCursorScreenPos();
+  const float width = style.ScrollbarSize;
+
+  ImGui::InvisibleButton("##vscroll", ImVec2(width, height));
+  const bool hovered = ImGui::IsItemHovered();
+  const bool active = ImGui::IsItemActive();
+
+  const size_t last_top = total > visible_rows ? total - visible_rows : 0;
+
+  // computed in double, a float can't tell rows apart in a multi terabyte file
+  const float grab_height = std::max(style.GrabMinSize,
+                                     total ? (float)(height * std::min(1.0, (double)visible_rows / total)) : height);
+  const float track = height - grab_height;
+  float grab_y = last_top ? (float)(track * ((double)top_row / last_top)) : 0.0f;
+
+  bool moved = false;
+  if (active && last_top) {
+    const float mouse_y = ImGui::GetIO().MousePos.y - pos.y;
+    if (grab < 0.0f) {
+      // dragging the grab keeps it under the mouse, clicking the track centers it there
+      grab = (mouse_y >= grab_y && mouse_y < grab_y + grab_height) ? mouse_y - grab_y : grab_height * 0.5f;
+    }
+    const double f = track > 0.0f ? std::max(0.0, std::min(1.0, (double)(mouse_y - grab) / track)) : 0.0;
+    row = (size_t)(f * last_top + 0.5);
+    grab_y = (float)(f * track);
+    moved = row != top_row;
+  } else if (!active) {
+    grab = -1.0f;
+  }
+
+  draw_list->AddRectFilled(pos, ImVec2(pos.x + width, pos.y + height), ImGui::GetColorU32(ImGuiCol_ScrollbarBg));
+  const ImU32 grab_color = ImGui::GetColorU32(active ? ImGuiCol_ScrollbarGrabActive
+                                                     : hovered ? ImGuiCol_ScrollbarGrabHovered : ImGuiCol_ScrollbarGrab);
+  draw_list->AddRectFilled(ImVec2(pos.x + 2.0f, pos.y + grab_y), ImVec2(pos.x + width - 2.0f, pos.y + grab_y + grab_height),
+                           grab_color, style.ScrollbarRounding);
+  return moved;
 }
 
-int HexEdit::isHighlighted(size_t addr) {
-  for(int i = 0; (size_t)i < m_views.size(); i++) {
-    if(m_views[i].start <= addr && m_views[i].end >= addr) {
-      return i;
+bool HexEdit::InputAddr(const char* label, size_t& off) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%0*" PRIX64, (int)AddrDigitsCount, AddrOf(off));
+  if (ImGui::InputText(label, buf, sizeof(buf), ImGuiInputTextFlags_CharsHexadecimal | ImGuiInputTextFlags_EnterReturnsTrue)) {
+    uint64_t addr;
+    if (sscanf(buf, "%" SCNx64, &addr) == 1) {
+      OffsetOf(addr, off);
+      return true;
     }
   }
-  return -1;
+  return false;
 }
 
 HexEdit::HexEdit() {
@@ -71,10 +142,14 @@ HexEdit::HexEdit() {
   Columns = 16;
   OptShowAscii = true;
   OptGreyOutZeroes = true;
+  OptInsertMode = false;
+  OptReadAhead = true;
+  OptParseFirmware = true;
   OptMidColumnsCount = 8;
   OptAddrDigitsCount = 0;
-  ReadFn = [](uint8_t* data, size_t off) -> uint8_t { return (data != 0) ? data[off] : 0; };
-  // todo: writefn
+  ReadFn = [this](size_t off, uint8_t* dst, size_t len) -> size_t { return m_edit.read(off, dst, len); };
+  // single byte writes are coalesced into one undo step as long as they're adjacent
+  WriteFn = [this](size_t off, uint8_t d) { m_edit.type(off, d, false); };
 
   // State/Internals
   ContentsWidthChanged = false;
@@ -99,24 +174,315 @@ HexEdit::HexEdit() {
 
 void HexEdit::LoadFile(const char* path) {
   if(fs::exists(fs::path(path))) {
-    std::ifstream f(path, std::ios::binary);
+    CloseFile();
+
+    // opened on a worker thread, PollLoader() picks the source up as soon as the first screenful arrived
+    m_loader.load(path, OptReadAhead, OptParseFirmware);
+  }
+}
+
+void HexEdit::PollLoader() {
+  auto source = m_loader.take();
+  if(!source)
+    return;
+  SetSource(std::move(source), m_loader.path());
+
+  if(m_open_offset != (size_t)-1) {
+    GotoAddr = m_open_offset;
+    m_cursor = m_open_offset;
+    m_click_start = m_open_offset;
+    m_click_current = m_open_offset + m_open_length - 1;
+    m_open_offset = (size_t)-1;
+  }
+}
+
+void HexEdit::OpenAt(const std::string& path, size_t off, size_t len) {
+  // after closing, which drops a pending selection
+  CloseFile();
+  m_loader.load(path.c_str(), OptReadAhead, false);
+  m_open_offset = off;
+  m_open_length = len;
+}
+
+void HexEdit::AttachProcess(int pid) {
+  CloseFile();
 
-    auto fsize = f.tellg();
-    f.seekg(0, std::ios::end);
-    fsize = f.tellg() - fsize;
+  auto process = std::unique_ptr<io::ProcessSource>(new io::ProcessSource);
+  if(!process->attach(pid))
+    return;
+
+  // there's no file to save the edits to
+  SetSource(std::move(process), "");
+  m_process_refresh_time = (float)ImGui::GetTime();
+}
+
+void HexEdit::RefreshProcess() {
+  auto process = dynamic_cast<io::ProcessSource*>(m_source.get());
+  // the workers read through the regions
+  if(!process || !process->pid() || m_search.isRunning() || m_strings.isRunning())
+    return;
+  m_process_refresh_time = (float)ImGui::GetTime();
 
-    f.seekg(0, std::ios::beg);
+  bool changed = false;
+  if(!process->refresh(&changed)) {
+    // the process is gone, so is its memory
+    process->detach();
+    changed = true;
+  }
+  if(!changed)
+    return;
+
+  // the offsets moved, the edits and results aren't at the same bytes anymore
+  if(m_edit.isModified())
+    LOG_WARN("the memory map of the process changed, the edits were dropped")
+  m_search.clear();
+  m_search_selected = (size_t)-1;
+  m_search_order.clear();
+  m_strings.clear();
+  m_strings_filter.reset();
+  m_strings_selected = (size_t)-1;
+  m_strings_top = 0;
+
+  m_segments = *process->segments();
+  m_cache.invalidate();
+  m_edit.setSource(&m_cache);
+  mem_size = m_edit.size();
+  m_cursor = std::min(m_cursor, mem_size ? mem_size - 1 : 0);
+  m_cursor_low_nibble = false;
+  ClearSelection();
+  m_prefetch_addr = (size_t)-1;
+}
+
+void HexEdit::SetSource(std::unique_ptr<io::DataSource> source, const std::string& path) {
+  m_source = std::move(source);
+  m_file_path = path;
+  if(m_source->segments())
+    m_segments = *m_source->segments();
+  else
+    m_segments.clear();
+  m_cache.setBudget((size_t)m_cache_budget_mb * 1024 * 1024);
+  m_cache.setSource(m_source.get());
+  m_edit.setSource(&m_cache);
+  mem_size = m_edit.size();
+  m_cursor = 0;
+  m_cursor_low_nibble = false;
+  ClearSelection();
+  m_window_base = 0;
+  m_pending_base = (size_t)-1;
+
+  // an index built earlier is picked up, building one is up to the user
+  const std::string index_path = IndexPath();
+  if (!index_path.empty()) {
+    auto index = std::make_shared<search::BlockIndex>();
+    if (index->load(index_path, m_source->size(), search::BlockIndex::stamp(m_file_path)))
+      m_index = index;
+  }
+}
+
+std::string HexEdit::IndexPath() const {
+  if (!m_source || m_source->isVolatile() || m_file_path.empty())
+    return "";
+  return (fs::absolute(fs::path(project_path)).parent_path() / fs::path(m_file_path).filename()).string() + ".idx";
+}
 
-    if(mem_data) {
-      free(mem_data);
+void HexEdit::BuildIndex() {
+  const std::string index_path = IndexPath();
+  if (index_path.empty())
+    return;
+  m_index.reset();
+  m_indexer.start(m_source.get(), index_path, search::BlockIndex::stamp(m_file_path));
+}
+
+void HexEdit::CloseFile() {
+  // the workers might still be reading ahead, searching or indexing
+  m_loader.cancel();
+  m_search.clear();
+  m_indexer.cancel();
+  m_index.reset();
+  m_strings.clear();
+  m_strings_filter.reset();
+  m_strings_selected = (size_t)-1;
+  m_strings_top = 0;
+  m_edit.setSource(nullptr);
+  m_cache.setSource(nullptr);
+  m_source.reset();
+  m_file_path.clear();
+  m_search_selected = (size_t)-1;
+  m_search_order.clear();
+  mem_size = 0;
+  base_display_addr = 0;
+  m_segments.clear();
+  m_prefetch_addr = (size_t)-1;
+  ClearSelection();
+  // a file opened from the folder results might not have loaded, its selection isn't for the next one
+  m_open_offset = (size_t)-1;
+}
+
+void HexEdit::SaveFile() {
+  if(!m_source || m_file_path.empty() || !m_edit.isModified())
+    return;
+
+  // firmware files are written in their own format, the source has the old content afterwards
+  auto image = dynamic_cast<io::FirmwareImage*>(m_source.get());
+  if(image) {
+    if(image->save(m_edit, m_file_path)) {
+      std::string path = m_file_path;
+      LoadFile(path.c_str());
     }
+    return;
+  }
 
-    mem_data = (uint8_t*)malloc(fsize);
+  switch(io::saveFile(m_edit, m_file_path)) {
+    case io::SaveResult_Failed:
+      break;
+    case io::SaveResult_InPlace:
+      // the file has the edited content now, the history would refer to the old one
+      m_cache.invalidate();
+      m_edit.reset();
+      m_indexer.cancel();
+      m_index.reset();
+      break;
+    case io::SaveResult_Rewritten: {
+      std::string path = m_file_path;
+      LoadFile(path.c_str());
+      break;
+    }
+  }
+  mem_size = m_edit.size();
+}
 
-    mem_size = fsize;
+void HexEdit::HandleEditKeys() {
+  ImGuiIO& io = ImGui::GetIO();
+
+  const size_t old_cursor = m_cursor;
+  if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_LeftArrow)) && m_cursor > 0)
+    m_cursor--;
+  if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_RightArrow)) && m_cursor + 1 < mem_size)
+    m_cursor++;
+  if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_UpArrow)) && m_cursor >= (size_t)Columns)
+    m_cursor -= Columns;
+  if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_DownArrow)) && m_cursor + Columns < mem_size)
+    m_cursor += Columns;
+  if (m_cursor != old_cursor) {
+    m_cursor_low_nibble = false;
+    m_edit.endTyping();
+  }
+
+  if (ReadOnly)
+    return;
 
-    f.read((char*)mem_data, fsize);
+  if (io.KeyCtrl && ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Z)))
+    Undo();
+  if (io.KeyCtrl && ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Y)))
+    Redo();
+  if (io.KeyCtrl)
+    return;
+
+  if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Delete)) && m_cursor < mem_size) {
+    m_edit.erase(m_cursor, 1);
+    m_cursor_low_nibble = false;
   }
+  if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Backspace)) && m_cursor > 0) {
+    m_cursor--;
+    m_edit.erase(m_cursor, 1);
+    m_cursor_low_nibble = false;
+  }
+
+  for (const ImWchar* c = io.InputCharacters; *c; c++) {
+    int nibble;
+    if (*c >= '0' && *c <= '9') nibble = *c - '0';
+    else if (*c >= 'a' && *c <= 'f') nibble = *c - 'a' + 10;
+    else if (*c >= 'A' && *c <= 'F') nibble = *c - 'A' + 10;
+    else continue;
+
+    if (m_cursor > m_edit.size())
+      break;
+
+    uint8_t b = 0;
+    if (!m_cursor_low_nibble) {
+      // a new byte is started in insert mode or when typing past the end
+      if (OptInsertMode || m_cursor == m_edit.size()) {
+        m_edit.type(m_cursor, (uint8_t)(nibble << 4), true);
+      } else {
+        ReadFn(m_cursor, &b, 1);
+        WriteFn(m_cursor, (uint8_t)((b & 0x0F) | (nibble << 4)));
+      }
+      m_cursor_low_nibble = true;
+    } else {
+      ReadFn(m_cursor, &b, 1);
+      WriteFn(m_cursor, (uint8_t)((b & 0xF0) | nibble));
+      m_cursor_low_nibble = false;
+      m_cursor++;
+    }
+  }
+
+  mem_size = m_edit.size();
+}
+
+void HexEdit::Undo() {
+  size_t off = m_edit.undo();
+  if (off != (size_t)-1) {
+    m_cursor = off;
+    m_cursor_low_nibble = false;
+  }
+  mem_size = m_edit.size();
+}
+
+void HexEdit::Redo() {
+  size_t off = m_edit.redo();
+  if (off != (size_t)-1) {
+    m_cursor = off;
+    m_cursor_low_nibble = false;
+  }
+  mem_size = m_edit.size();
+}
+
+bool HexEdit::HasSelection() const {
+  return m_click_start != (size_t)-1 && std::max(m_click_start, m_click_current) < mem_size;
+}
+
+void HexEdit::ClearSelection() {
+  m_clicked = false;
+  m_click_start = (size_t)-1;
+  m_click_current = (size_t)-1;
+}
+
+void HexEdit::FillSelection(uint8_t value) {
+  // fill would grow the data for a range past its end
+  if (!HasSelection())
+    return;
+  const size_t start = std::min(m_click_start, m_click_current);
+  const size_t end = std::max(m_click_start, m_click_current);
+  m_edit.fill(start, end - start + 1, value);
+  mem_size = m_edit.size();
+}
+
+void HexEdit::PasteHex(const char* text) {
+  std::vector<uint8_t> bytes;
+  int high = -1;
+  for (const char* c = text; c && *c; c++) {
+    int nibble;
+    if (*c >= '0' && *c <= '9') nibble = *c - '0';
+    else if (*c >= 'a' && *c <= 'f') nibble = *c - 'a' + 10;
+    else if (*c >= 'A' && *c <= 'F') nibble = *c - 'A' + 10;
+    else continue;
+
+    if (high < 0) {
+      high = nibble;
+    } else {
+      bytes.push_back((uint8_t)((high << 4) | nibble));
+      high = -1;
+    }
+  }
+
+  if (bytes.empty() || m_cursor > mem_size)
+    return;
+
+  if (OptInsertMode)
+    m_edit.insert(m_cursor, bytes.data(), bytes.size());
+  else
+    m_edit.overwrite(m_cursor, bytes.data(), bytes.size());
+  mem_size = m_edit.size();
 }
 
 void HexEdit::LoadProject() {
@@ -126,9 +492,19 @@ void HexEdit::LoadProject() {
     f >> j;
 
     m_views.clear();
+    m_views.reserve(j["views"].size());
     for(auto& element : j["views"]) {
-      m_views.push_back(element);
+      // the index of the parent, which comes first. the ids of a new list are the indices
+      const int parent = element.value("parent", -1);
+      const ImVec4 color(element.at("color_r").get<float>(), element.at("color_g").get<float>(),
+                         element.at("color_b").get<float>(), element.at("color_a").get<float>());
+      m_views.add(element.at("start").get<size_t>(), element.at("end").get<size_t>(),
+                  element.at("name").get<std::string>().c_str(), ImGui::ColorConvertFloat4ToU32(color),
+                  HexViewMode_Filled,
+                  parent >= 0 && (size_t)parent < m_views.size() ? (uint32_t)parent : ViewStore::NoView);
     }
+    m_selected_view = ViewStore::NoView;
+    m_view_list.clear();
   }
 }
 
@@ -136,7 +512,19 @@ void HexEdit::Save() {
   std::ofstream f(project_path);
   json j;
 
-  j["views"] = m_views;
+  j["views"] = json::array();
+  for(size_t i = 0; i < m_views.size(); i++) {
+    const ImVec4 color = ImGui::ColorConvertU32ToFloat4(m_views.color(i));
+    const uint32_t parent = m_views.parent(i);
+    j["views"].push_back(json{{"name", m_views.name(i)},
+                              {"parent", parent == ViewStore::NoView ? -1 : (int)m_views.indexOf(parent)},
+                              {"start", m_views.start(i)},
+                              {"end", m_views.end(i)},
+                              {"color_r", color.x},
+                              {"color_g", color.y},
+                              {"color_b", color.z},
+                              {"color_a", color.w}});
+  }
 
   f << j;
 }
@@ -145,7 +533,7 @@ void HexEdit::CalcSizes() {
   ImGuiStyle& style = ImGui::GetStyle();
   AddrDigitsCount = OptAddrDigitsCount;
   if (AddrDigitsCount == 0)
-    for (size_t n = base_display_addr + mem_size - 1; n > 0; n >>= 4)
+    for (uint64_t n = MaxAddr(); n > 0; n >>= 4)
       AddrDigitsCount++;
   LineHeight = (float)(size_t)ImGui::GetTextLineHeight();
   GlyphWidth = ImGui::CalcTextSize("F").x + 1;                  // We assume the font is mono-space
@@ -173,6 +561,15 @@ void HexEdit::BeginWindow(const char *title, size_t w, size_t h, size_t m_delta)
   if(!w || !h)
     return;
 
+  PollLoader();
+  if (ImGui::GetTime() - m_process_refresh_time >= 1.0f)
+    RefreshProcess();
+  if (m_search.poll())
+    AddSearchViews();
+  if (auto index = m_indexer.poll())
+    m_index = index;
+  m_strings.poll();
+  m_folder_search.poll();
   CalcSizes();
   ImGui::SetNextWindowSizeConstraints(ImVec2(0.0f, 0.0f), ImVec2(HexEdit_WindowWidth, FLT_MAX));
 
@@ -182,6 +579,7 @@ void HexEdit::BeginWindow(const char *title, size_t w, size_t h, size_t m_delta)
   {
     /* menu bar and file handling */
     bool file_open_dialog = false;
+    bool attach_dialog = false;
     if (ImGui::BeginMenuBar())
     {
       if (ImGui::BeginMenu("File"))
@@ -190,6 +588,19 @@ void HexEdit::BeginWindow(const char *title, size_t w, size_t h, size_t m_delta)
           file_open_dialog = true;
         }
 
+        if (ImGui::MenuItem("Attach Process")) {
+          attach_dialog = true;
+        }
+
+        if (ImGui::MenuItem("Refresh memory map", NULL, false, dynamic_cast<io::ProcessSource*>(m_source.get()) &&
+                            !m_search.isRunning() && !m_strings.isRunning())) {
+          RefreshProcess();
+        }
+
+        if(ImGui::MenuItem("Save File", NULL, false, !ReadOnly && !m_file_path.empty() && m_edit.isModified())) {
+          SaveFile();
+        }
+
         if(ImGui::MenuItem("Save Project")) {
           Save();
         }
@@ -199,12 +610,11 @@ void HexEdit::BeginWindow(const char *title, size_t w, size_t h, size_t m_delta)
         }
 
         if (ImGui::MenuItem("Close")) {
-          if(mem_data)
-            free(mem_data);
-          mem_data = NULL;
-          mem_size = 0;
+          CloseFile();
 
           m_views.clear();
+          m_selected_view = ViewStore::NoView;
+          m_view_list.clear();
         }
 
         if(ImGui::MenuItem("Reset")) {
@@ -216,6 +626,41 @@ void HexEdit::BeginWindow(const char *title, size_t w, size_t h, size_t m_delta)
         }
         ImGui::EndMenu();
       }
+      if (ImGui::BeginMenu("Edit", !ReadOnly))
+      {
+        if (ImGui::MenuItem("Undo", "CTRL+Z", false, m_edit.canUndo()))
+          Undo();
+        if (ImGui::MenuItem("Redo", "CTRL+Y", false, m_edit.canRedo()))
+          Redo();
+
+        ImGui::Separator();
+
+        if (ImGui::MenuItem("Paste hex"))
+          PasteHex(ImGui::GetClipboardText());
+
+        static char fill_value[3] = "00";
+        ImGui::PushItemWidth(32);
+        ImGui::InputText("##fill", fill_value, sizeof(fill_value), ImGuiInputTextFlags_CharsHexadecimal);
+        ImGui::PopItemWidth();
+        ImGui::SameLine();
+        if (ImGui::MenuItem("Fill selection", NULL, false, HasSelection())) {
+          unsigned int value = 0;
+          sscanf(fill_value, "%x", &value);
+          FillSelection((uint8_t)value);
+        }
+
+        ImGui::EndMenu();
+      }
+      if (ImGui::BeginMenu("Search"))
+      {
+        ImGui::MenuItem("Find bytes", NULL, &m_show_search);
+        ImGui::MenuItem("Strings", NULL, &m_show_strings);
+        // blocks the index rules out aren't read by byte and signature searches
+        if (ImGui::MenuItem(m_index ? "Rebuild index" : "Build index", NULL, false,
+                            !IndexPath().empty() && !m_indexer.isRunning()))
+          BuildIndex();
+        ImGui::EndMenu();
+      }
       // Options menu
       if (ImGui::BeginMenu("Options"))
       {
@@ -225,6 +670,15 @@ void HexEdit::BeginWindow(const char *title, size_t w, size_t h, size_t m_delta)
 
         if (ImGui::Checkbox("Show Ascii", &OptShowAscii)) ContentsWidthChanged = true;
         ImGui::Checkbox("Grey out zeroes", &OptGreyOutZeroes);
+        ImGui::Checkbox("Read only", &ReadOnly);
+        ImGui::Checkbox("Insert mode", &OptInsertMode);
+        ImGui::Checkbox("Read ahead on open", &OptReadAhead);
+        ImGui::Checkbox("Parse hex/srec/elf files", &OptParseFirmware);
+
+        ImGui::PushItemWidth(96);
+        if (ImGui::DragInt("##cache", &m_cache_budget_mb, 1.0f, 1, 4096, "%.0f MB cache"))
+          m_cache.setBudget((size_t)m_cache_budget_mb * 1024 * 1024);
+        ImGui::PopItemWidth();
 
         ImGui::EndMenu();
       }
@@ -251,6 +705,25 @@ void HexEdit::BeginWindow(const char *title, size_t w, size_t h, size_t m_delta)
       ImGui::EndPopup();
     }
 
+    if (attach_dialog)
+      ImGui::OpenPopup("Attach Process");
+    if (ImGui::BeginPopupModal("Attach Process", NULL, ImGuiWindowFlags_AlwaysAutoResize))
+    {
+      static int pid = 0;
+      ImGui::Text("process id\n\n");
+      ImGui::Separator();
+      ImGui::InputInt("##pid", &pid, 0, 0);
+
+      if (ImGui::Button("OK", ImVec2(120,0))) {
+        AttachProcess(pid);
+
+        ImGui::CloseCurrentPopup();
+      }
+      if (ImGui::Button("Cancel", ImVec2(120,0))) { ImGui::CloseCurrentPopup(); }
+
+      ImGui::EndPopup();
+    }
+
     if (ImGui::IsWindowHovered(ImGuiHoveredFlags_RootAndChildWindows) && ImGui::IsMouseClicked(1))
       ImGui::OpenPopup("context");
     DrawHexEdit();
@@ -290,6 +763,22 @@ void HexEdit::BeginWindow(const char *title, size_t w, size_t h, size_t m_delta)
   DrawHexTable();
   ImGui::End();
 
+  if (m_show_search) {
+    ImGui::SetNextWindowSize(ImVec2(HexView_WindowWidth * 0.5f, h * 0.5f), ImGuiCond_FirstUseEver);
+    if (ImGui::Begin("Search", &m_show_search))
+      DrawSearch();
+    ImGui::End();
+  }
+
+  if (m_show_strings) {
+    // over the graph, next to the view window
+    ImGui::SetNextWindowPos(ImVec2(HexEdit_WindowWidth + HexView_WindowWidth, 0), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(HexGraph_WindowWidth, h * 0.5f), ImGuiCond_FirstUseEver);
+    if (ImGui::Begin("Strings", &m_show_strings))
+      DrawStrings();
+    ImGui::End();
+  }
+
   ImGui::Begin("debug info: ", NULL, ImGuiWindowFlags_NoMove|ImGuiWindowFlags_ResizeFromAnySide|
                                      ImGuiWindowFlags_NoTitleBar|ImGuiWindowFlags_NoScrollbar);
   ImGui::SetWindowPos(ImVec2((HexEdit_WindowWidth + HexView_WindowWidth), h/2));
@@ -314,16 +803,11 @@ void HexEdit::BeginWindow(const char *title, size_t w, size_t h, size_t m_delta)
   float foo,bar,baz;
   SDL_GetDisplayDPI(0,&foo,&bar,&baz);
   ImGui::Text("dpi: %f %f %f", foo, bar, baz);
+  ImGui::Text("views: %zu, %zu KB", m_views.size(), m_views.memoryUsage() / 1024);
 
   ImGui::End();
 }
 
-#ifdef _MSC_VER
-#define _PRISizeT   "IX"
-#else
-#define _PRISizeT   "zX"
-#endif
-
 void HexEdit::DrawRightClickPopup() {
   if(ImGui::IsMouseClicked(1)) {
     ImGui::OpenPopup("##contextmenu");
@@ -331,25 +815,14 @@ void HexEdit::DrawRightClickPopup() {
   if (ImGui::BeginPopup("##contextmenu"))
   {
     ImGui::PushItemWidth(60);
-    if(ImGui::Button("create view")) {
-      HexView hv;
-      hv.id = m_views.size();
-      auto name = "New View " + std::to_string(hv.id);
-
-      if(name.size() > sizeof(hv.name)-1)
-        name.resize(sizeof(hv.name)-1);
-
-      strcpy(hv.name, name.data());
-      hv.start = std::min(m_click_start, m_click_current);
-      hv.end = std::max(m_click_start, m_click_current);
-      hv.color = ImColor(IM_COL32(0,128,128,255));
-      m_views.push_back(hv);
+    if(HasSelection() && ImGui::Button("create view")) {
+      auto name = "New View " + std::to_string(m_views.size());
+      const size_t start = std::min(m_click_start, m_click_current), end = std::max(m_click_start, m_click_current);
+      // nested into the view it's in
+      m_selected_view = m_views.add(start, end, name.c_str(), IM_COL32(0,128,128,255), HexViewMode_Filled,
+                                    ViewAround(start, end));
 
-      m_clicked = false;
-      m_click_start = 0;
-      m_click_current = 0;
-
-      m_selected_view = m_views.size()-1;
+      ClearSelection();
 
       ImGui::CloseCurrentPopup();
     }
@@ -364,17 +837,46 @@ void HexEdit::DrawHexEdit() {
   DrawRightClickPopup();
 
   const float footer_height_to_reserve = ImGui::GetStyle().ItemSpacing.y + ImGui::GetFrameHeightWithSpacing(); // 1 separator, 1 input text
-  ImGui::BeginChild("##scrolling", ImVec2(0, -footer_height_to_reserve));
+  // the scrollbar of the child only covers the scroll window, the virtual one next to it covers everything
+  ImGui::BeginChild("##scrolling", ImVec2(-style.ScrollbarSize, -footer_height_to_reserve), false,
+                    ImGuiWindowFlags_NoScrollbar);
   ImDrawList* draw_list = ImGui::GetWindowDrawList();
+  const float scroll_height = ImGui::GetWindowHeight();
 
   ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(0, 0));
   ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0, 0));
 
-  const int line_total_count = (int)((mem_size + Columns - 1) / Columns);
-  ImGuiListClipper clipper(line_total_count, LineHeight);
+  // the scroll position set together with the pending base is in effect now
+  if (m_pending_base != (size_t)-1) {
+    m_window_base = m_pending_base;
+    m_pending_base = (size_t)-1;
+  }
 
-  const size_t visible_start_addr = clipper.DisplayStart * Columns;
-  const size_t visible_end_addr = clipper.DisplayEnd * Columns;
+  const size_t line_total_count = RowCount();
+  const size_t window_rows = std::min(line_total_count, WindowRows);
+  m_window_base = std::min(m_window_base, line_total_count - window_rows);
+
+  const size_t top_row = m_window_base + (size_t)(ImGui::GetScrollY() / LineHeight);
+  const size_t visible_rows = (size_t)(scroll_height / LineHeight);
+
+  // move the window along before the position reaches one of its edges
+  if (m_pending_base == (size_t)-1 && line_total_count > WindowRows) {
+    const size_t window_row = top_row - m_window_base;
+    if ((window_row < WindowRows / 4 && m_window_base > 0) ||
+        (window_row > WindowRows * 3 / 4 && m_window_base + WindowRows < line_total_count))
+      ScrollToRow(top_row, ImGui::GetScrollY() - (float)window_row * LineHeight);
+  }
+
+  ImGuiListClipper clipper((int)window_rows, LineHeight);
+
+  const size_t visible_start_addr = (m_window_base + clipper.DisplayStart) * Columns;
+  const size_t visible_end_addr = (m_window_base + clipper.DisplayEnd) * Columns;
+
+  // fault in the visible pages in the background when the view moved
+  if (visible_start_addr != m_prefetch_addr) {
+    m_edit.prefetch(visible_start_addr, visible_end_addr - visible_start_addr);
+    m_prefetch_addr = visible_start_addr;
+  }
 
   // Draw vertical separator
   ImVec2 window_pos = ImGui::GetWindowPos();
@@ -385,120 +887,153 @@ void HexEdit::DrawHexEdit() {
   const ImU32 color_text = ImGui::GetColorU32(ImGuiCol_Text);
   const ImU32 color_disabled = OptGreyOutZeroes ? ImGui::GetColorU32(ImGuiCol_TextDisabled) : color_text;
 
-  float scrolly = ImGui::GetScrollY();
-
-  // highlights a byte, if there's a view for it
-  // returns whether the byte was highlighted or not
-  auto highlight_fnc = [&](HexView& v) {
-    auto min = std::max((size_t)0, v.start);
-    auto max = std::min(v.end, mem_size);
-
-    auto xoff = window_pos.x + PosHexStart;
-    auto yoff = window_pos.y - ImGui::GetScrollY();
-
-    switch(v.mode) {
+  // the views on the visible rows, cut to them. everything is drawn as rectangles (lines are thin ones) in
+  // batches, so the cost depends on what's visible and not on the number of views
+  const size_t first_row = m_window_base + clipper.DisplayStart;
+  const size_t end_row = m_window_base + clipper.DisplayEnd;
+  const float xoff = window_pos.x + PosHexStart;
+  const float yoff = window_pos.y - ImGui::GetScrollY();
+  const float right = xoff + HexCellWidth * (Columns - 1) + 0.5f * GlyphWidth * ((Columns - 1) / 8) + 2 * GlyphWidth;
+  auto row_y = [&](size_t row) { return yoff + LineHeight * (float)((int64_t)row - (int64_t)m_window_base); };
+  auto col_x = [&](size_t col) { return xoff + HexCellWidth * col + 0.5f * GlyphWidth * (col / 8); };
+  auto flush_rects = [&]() {
+    draw_list->PrimReserve((int)m_highlight_rects.size() * 6, (int)m_highlight_rects.size() * 4);
+    for (const HighlightRect& r : m_highlight_rects)
+      draw_list->PrimRect(r.min, r.max, r.color);
+    m_highlight_rects.clear();
+  };
+  auto rect = [&](float x0, float y0, float x1, float y1, ImU32 color) {
+    m_highlight_rects.push_back(HighlightRect{ImVec2(std::min(x0, x1), std::min(y0, y1)),
+                                              ImVec2(std::max(x0, x1), std::max(y0, y1)), color});
+    if (m_highlight_rects.size() == HighlightBatch)
+      flush_rects();
+  };
+  // the lines are 3 pixels thick
+  auto hline = [&](float x0, float x1, float y, ImU32 color) { rect(x0, y - 1.5f, x1, y + 1.5f, color); };
+  auto vline = [&](float x, float y0, float y1, ImU32 color) { rect(x - 1.5f, y0, x + 1.5f, y1, color); };
+
+  auto highlight_fnc = [&](size_t start, size_t end, ImU32 color, HexViewMode mode) {
+    const size_t min = start;
+    const size_t max = std::min(end, mem_size);
+    if (min > max)
+      return;
+
+    const size_t r0 = min / Columns, c0 = min - r0 * Columns;
+    const size_t r1 = max / Columns, c1 = max - r1 * Columns;
+    const bool first_visible = r0 >= first_row && r0 < end_row;
+    const bool last_visible = r1 >= first_row && r1 < end_row;
+    // the rows in between which are visible
+    const size_t m0 = std::max(r0 + 1, first_row), m1 = std::min(r1, end_row);
+
+    switch(mode) {
       case HexViewMode_Filled: {
-        if(getRow(max) - getRow(min) == 0) {
-          draw_list->AddRectFilled(ImVec2(xoff + getTopX(min), yoff + getTopY(min)),
-                                   ImVec2(xoff + getBottomX(max), yoff + getBottomY(max)),
-                                   ImColor(v.color));
-        } else {
-          draw_list->AddRectFilled(ImVec2(xoff + getTopX(min), yoff + getTopY(min)),
-                                   ImVec2(xoff + getBottomX(Columns - 1), yoff + getBottomY(min)),
-                                   ImColor(v.color));
-
-          if(getRow(max) - getRow(min) > 1) {
-            draw_list->AddRectFilled(ImVec2(xoff, yoff + (getRow(min)+1)*LineHeight),
-                                     ImVec2(xoff + getBottomX(Columns - 1), yoff + (getRow(max))*LineHeight),
-                                     ImColor(v.color));
-          }
-
-          draw_list->AddRectFilled(ImVec2(xoff, yoff + getTopY(max)),
-                                   ImVec2(xoff + getBottomX(max), yoff + getBottomY(max)),
-                                   ImColor(v.color));
+        if (r0 == r1) {
+          if (first_visible)
+            rect(col_x(c0), row_y(r0), col_x(c1) + 2 * GlyphWidth, row_y(r0 + 1), color);
+          break;
         }
+        if (first_visible)
+          rect(col_x(c0), row_y(r0), right, row_y(r0 + 1), color);
+        if (m0 < m1)
+          rect(xoff, row_y(m0), right, row_y(m1), color);
+        if (last_visible)
+          rect(xoff, row_y(r1), col_x(c1) + 2 * GlyphWidth, row_y(r1 + 1), color);
         break;
       }
       case HexViewMode_Line: {
-        if(getRow(max) - getRow(min) == 0) {
-          draw_list->AddLine(ImVec2(xoff + getTopX(min), yoff + getTopY(min)),
-                             ImVec2(xoff + getBottomX(max), yoff + getTopY(max)),
-                             ImColor(v.color), 3.0f);
-          draw_list->AddLine(ImVec2(xoff + getTopX(min), yoff + getBottomY(min)),
-                             ImVec2(xoff + getBottomX(max), yoff + getBottomY(max)),
-                             ImColor(v.color), 3.0f);
-          draw_list->AddLine(ImVec2(xoff + getTopX(min), yoff + getTopY(min)),
-                             ImVec2(xoff + getTopX(min), yoff + getBottomY(min)),
-                             ImColor(v.color), 3.0f);
-          draw_list->AddLine(ImVec2(xoff + getBottomX(max), yoff + getTopY(max)),
-                             ImVec2(xoff + getBottomX(max), yoff + getBottomY(max)),
-                             ImColor(v.color), 3.0f);
-        } else {
-          draw_list->AddLine(ImVec2(xoff + getTopX(min), yoff + getTopY(min)),
-                             ImVec2(xoff + getBottomX(Columns-1), yoff + getTopY(min)),
-                             ImColor(v.color), 3.0f);
-          draw_list->AddLine(ImVec2(xoff + getTopX(min), yoff + getBottomY(min)),
-                             ImVec2(xoff, yoff + getBottomY(min)),
-                             ImColor(v.color), 3.0f);
-          draw_list->AddLine(ImVec2(xoff + getTopX(min), yoff + getTopY(min)),
-                             ImVec2(xoff + getTopX(min), yoff + getBottomY(min)),
-                             ImColor(v.color), 3.0f);
-          draw_list->AddLine(ImVec2(xoff + getBottomX(Columns-1), yoff + getTopY(min)),
-                             ImVec2(xoff + getBottomX(Columns-1), yoff + getBottomY(min)),
-                             ImColor(v.color), 3.0f);
-
-          if(getRow(max) - getRow(min) > 1) {
-            draw_list->AddLine(ImVec2(xoff, yoff + getBottomY(min)),
-                               ImVec2(xoff, yoff + getTopY(max)),
-                               ImColor(v.color), 3.0f);
-            draw_list->AddLine(ImVec2(xoff + getBottomX(Columns-1), yoff + getBottomY(min)),
-                               ImVec2(xoff + getBottomX(Columns-1), yoff + getTopY(max)),
-                               ImColor(v.color), 3.0f);
+        const float x0 = col_x(c0), x1 = col_x(c1) + 2 * GlyphWidth;
+        if (r0 == r1) {
+          if (first_visible) {
+            hline(x0, x1, row_y(r0), color);
+            hline(x0, x1, row_y(r0 + 1), color);
+            vline(x0, row_y(r0), row_y(r0 + 1), color);
+            vline(x1, row_y(r0), row_y(r0 + 1), color);
           }
-
-          draw_list->AddLine(ImVec2(xoff + getBottomX(max), yoff + getBottomY(max)),
-                             ImVec2(xoff, yoff + getBottomY(max)),
-                             ImColor(v.color), 3.0f);
-          draw_list->AddLine(ImVec2(xoff + getBottomX(max), yoff + getTopY(max)),
-                             ImVec2(xoff + getBottomX(Columns-1), yoff + getTopY(max)),
-                             ImColor(v.color), 3.0f);
-          draw_list->AddLine(ImVec2(xoff + getBottomX(max), yoff + getBottomY(max)),
-                             ImVec2(xoff + getBottomX(max), yoff + getTopY(max)),
-                             ImColor(v.color), 3.0f);
-          draw_list->AddLine(ImVec2(xoff, yoff + getBottomY(max)),
-                             ImVec2(xoff, yoff + getTopY(max)),
-                             ImColor(v.color), 3.0f);
+          break;
+        }
+        if (first_visible) {
+          hline(x0, right, row_y(r0), color);
+          hline(xoff, x0, row_y(r0 + 1), color);
+          vline(x0, row_y(r0), row_y(r0 + 1), color);
+          vline(right, row_y(r0), row_y(r0 + 1), color);
+        }
+        if (m0 < m1) {
+          vline(xoff, row_y(m0), row_y(m1), color);
+          vline(right, row_y(m0), row_y(m1), color);
+        }
+        if (last_visible) {
+          hline(xoff, x1, row_y(r1 + 1), color);
+          hline(x1, right, row_y(r1), color);
+          vline(x1, row_y(r1), row_y(r1 + 1), color);
+          vline(xoff, row_y(r1), row_y(r1 + 1), color);
         }
         break;
       }
     }
-
   };
 
-  HexView hv;
-  strcpy(hv.name, "New View");
-  hv.start = std::min(m_click_start, m_click_current);
-  hv.end = std::max(m_click_start, m_click_current);
-  hv.color = ImColor(IM_COL32(255,0,0,128));
-  hv.mode = HexViewMode_Line;
-
-  // highlight views
-  for(size_t i=0; i < m_views.size(); i++) {
-    highlight_fnc(m_views[i]);
+  m_highlight_rects.clear();
+  if (first_row < end_row) {
+    UpdateViewIndex();
+    m_visible_views.clear();
+    m_view_index.overlapping(first_row * Columns, end_row * Columns - 1, m_visible_views);
+    // only the deepest level on screen is drawn, a view with children in the visible rows is left to them
+    m_covered_views.clear();
+    for (uint32_t i : m_visible_views)
+      if (m_views.parent(i) != ViewStore::NoView)
+        m_covered_views.push_back(m_views.parent(i));
+    std::sort(m_covered_views.begin(), m_covered_views.end());
+    // in the order of their start, like they're listed
+    for (uint32_t i : m_visible_views)
+      if (!std::binary_search(m_covered_views.begin(), m_covered_views.end(), m_views.id(i)))
+        highlight_fnc(m_views.start(i), m_views.end(i), m_views.color(i), m_views.mode(i));
   }
   // highlight current selection
-  highlight_fnc(hv);
+  highlight_fnc(std::min(m_click_start, m_click_current), std::max(m_click_start, m_click_current),
+                IM_COL32(255,0,0,128), HexViewMode_Line);
+
+  flush_rects();
+
+  if (ImGui::IsWindowFocused())
+    HandleEditKeys();
+
+  // only the visible pages are read each frame, so dropping the cache refreshes exactly those
+  if (m_cache.isVolatile())
+    m_cache.invalidate();
+
+  const ImU32 color_cursor = ImGui::GetColorU32(ImGuiCol_PlotLinesHovered);
+
+  m_line_buf.resize(Columns);
 
   // render all visible lines
   for (int line_i = clipper.DisplayStart; line_i < clipper.DisplayEnd; line_i++)
   {
     // calculate first address of line
-    size_t addr = (size_t)(line_i * Columns);
+    size_t addr = (m_window_base + line_i) * Columns;
+    const size_t line_addr = addr;
+
+    // fetch the whole line at once, hex and ascii columns are rendered from it
+    const size_t line_len = ReadFn(addr, m_line_buf.data(), Columns);
     // render first line number
-    ImGui::Text("%0*" _PRISizeT ": ", (int)AddrDigitsCount, base_display_addr + addr);
+    ImGui::Text("%0*" PRIX64 ": ", (int)AddrDigitsCount, AddrOf(addr));
+
+    if (!m_segments.empty()) {
+      const io::Segment& segment = m_segments.segments()[m_segments.segmentAt(line_addr)];
+      if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("%s %" PRIX64 "..%" PRIX64, segment.name.c_str(), segment.addr,
+                          segment.addr + (segment.size ? segment.size - 1 : 0));
+
+      // mark rows where a new segment starts, there's a hole in the addresses
+      const io::Segment& last = m_segments.segments()[m_segments.segmentAt(line_addr + Columns - 1)];
+      if (last.offset > line_addr || (segment.offset == line_addr && line_addr > 0)) {
+        ImVec2 pos = ImGui::GetItemRectMin();
+        draw_list->AddLine(ImVec2(pos.x, pos.y), ImVec2(window_pos.x + PosHexEnd, pos.y),
+                           ImGui::GetColorU32(ImGuiCol_Separator));
+      }
+    }
 
     // render all hex numbers
-    for (int n = 0; n < Columns && addr < mem_size; n++, addr++)
+    for (int n = 0; n < Columns && (size_t)n < line_len; n++, addr++)
     {
       float uint8_t_pos_x = PosHexStart + HexCellWidth * n;
       if (OptMidColumnsCount > 0)
@@ -506,22 +1041,28 @@ void HexEdit::DrawHexEdit() {
       ImGui::SameLine(uint8_t_pos_x);
 
       // read current byte
-      uint8_t b = ReadFn(mem_data, addr);
+      uint8_t b = m_line_buf[n];
 
-      auto handleTooltipAndClick = [&]() {
-        m_current_view = isHighlighted(addr);
+      auto handleTooltipAndClick = [&](bool low_nibble) {
+        // only the hovered nibble needs to know its view
+        const bool hovered = ImGui::IsItemHovered();
+        if (hovered)
+          m_current_view = ViewAt(addr);
 
         // text selection
         if (ImGui::IsMouseDown(0)) {
-          if (ImGui::IsItemHovered()) {
+          if (hovered) {
             if(m_current_view >= 0 && (size_t)m_current_view < m_views.size()) {
-              m_selected_view = m_views[m_current_view].id;
+              m_selected_view = m_views.id(m_current_view);
             }
 
             if (!m_clicked) {
               m_clicked = true;
               m_click_start = addr;
               m_click_current = addr;
+              m_cursor = addr;
+              m_cursor_low_nibble = low_nibble;
+              m_edit.endTyping();
             } else {
               m_click_current = addr;
             }
@@ -534,40 +1075,38 @@ void HexEdit::DrawHexEdit() {
         }
 
         // tooltip
-        if (ImGui::IsItemHovered()) {
+        if (hovered) {
           if(m_current_view >= 0 && (size_t)m_current_view < m_views.size()) {
-            ImGui::SetTooltip("%s | %lu bytes", m_views[m_current_view].name,
-                              1 + (m_views[m_current_view].end - m_views[m_current_view].start));
+            ImGui::SetTooltip("%s | %" PRIu64 " bytes", m_views.name(m_current_view),
+                              1 + (m_views.end(m_current_view) - m_views.start(m_current_view)));
           }
         }
+
+        // edit cursor
+        if (!ReadOnly && addr == m_cursor && low_nibble == m_cursor_low_nibble) {
+          ImVec2 min = ImGui::GetItemRectMin();
+          draw_list->AddRect(min, ImVec2(min.x + GlyphWidth, min.y + LineHeight), color_cursor);
+        }
       };
 
       if (b == 0 && OptGreyOutZeroes) {
         ImGui::TextDisabled("0");
-        handleTooltipAndClick();
+        handleTooltipAndClick(false);
 
         ImGui::SameLine(uint8_t_pos_x + GlyphWidth);
 
         ImGui::TextDisabled("0 ");
-        handleTooltipAndClick();
+        handleTooltipAndClick(true);
       }
       else {
         ImGui::Text("%01X", b >> 4);
-        handleTooltipAndClick();
+        handleTooltipAndClick(false);
 
         ImGui::SameLine(uint8_t_pos_x + GlyphWidth);
 
         ImGui::Text("%01X ", b & 0x0F);
-        handleTooltipAndClick();
+        handleTooltipAndClick(true);
       }
-
-      ImGui::SetKeyboardFocusHere();
-      ImGui::CaptureKeyboardFromApp(true);
-      if(ImGui::GetKeyPressedAmount(ImGui::GetKeyIndex(ImGuiKey_LeftArrow), 100, 1)) {
-      }
-      if(ImGui::GetKeyPressedAmount(ImGui::GetKeyIndex(ImGuiKey_RightArrow), 100, 1)) {
-      }
-
     }
 
     if (OptShowAscii)
@@ -575,7 +1114,7 @@ void HexEdit::DrawHexEdit() {
       // Draw ASCII values
       ImGui::SameLine(PosAsciiStart);
       ImVec2 pos = ImGui::GetCursorScreenPos();
-      addr = line_i * Columns;
+      addr = line_addr;
       ImGui::PushID(line_i);
       if (ImGui::InvisibleButton("ascii", ImVec2(PosAsciiEnd - PosAsciiStart, LineHeight)))
       {
@@ -583,9 +1122,9 @@ void HexEdit::DrawHexEdit() {
         //DataEditingTakeFocus = true;
       }
       ImGui::PopID();
-      for (int n = 0; n < Columns && addr < mem_size; n++, addr++)
+      for (int n = 0; n < Columns && (size_t)n < line_len; n++, addr++)
       {
-        unsigned char c = ReadFn(mem_data, addr);
+        unsigned char c = m_line_buf[n];
         char display_c = (c < 32 || c >= 128) ? '.' : c;
         draw_list->AddText(pos, (display_c == '.') ? color_disabled : color_text, &display_c, &display_c + 1);
         pos.x += GlyphWidth;
@@ -596,20 +1135,67 @@ void HexEdit::DrawHexEdit() {
   ImGui::PopStyleVar(2);
   ImGui::EndChild();
 
+  ImGui::SameLine(0, 0);
+  size_t scroll_row;
+  if (DrawScrollbar(scroll_height, line_total_count, top_row, visible_rows, m_scrollbar_grab, scroll_row)) {
+    ImGui::BeginChild("##scrolling");
+    ScrollToRow(scroll_row);
+    ImGui::EndChild();
+  }
+
   ImGui::Separator();
 
-  ImGui::Text("Position: %f", scrolly);
+  if (m_loader.isRunning()) {
+    if (m_loader.state() == io::LoaderState_Opening) {
+      ImGui::Text("opening %s", m_loader.path().c_str());
+    } else {
+      ImGui::ProgressBar(m_loader.progress(), ImVec2(HexCellWidth * 4, 0), "reading");
+    }
+    ImGui::SameLine();
+    if (ImGui::SmallButton("cancel"))
+      m_loader.cancel();
+    ImGui::SameLine();
+  }
+
+  if (m_indexer.isRunning()) {
+    ImGui::ProgressBar(m_indexer.progress(), ImVec2(HexCellWidth * 4, 0), "indexing");
+    ImGui::SameLine();
+    if (ImGui::SmallButton("stop##index"))
+      m_indexer.cancel();
+    ImGui::SameLine();
+  }
+
+  if (m_strings.isRunning()) {
+    ImGui::ProgressBar(m_strings.progress(), ImVec2(HexCellWidth * 4, 0), "strings");
+    ImGui::SameLine();
+    if (ImGui::SmallButton("stop##strings"))
+      m_strings.cancel();
+    ImGui::SameLine();
+  }
+
+  if (m_search.isRunning()) {
+    ImGui::ProgressBar(m_search.progress(), ImVec2(HexCellWidth * 4, 0), "searching");
+    ImGui::SameLine();
+    if (ImGui::SmallButton("stop"))
+      m_search.cancel();
+    ImGui::SameLine();
+  }
+
+  ImGui::Text("Row %zu/%zu", top_row, line_total_count);
 
   ImGui::SameLine();
-  ImGui::Text("Range %0*" _PRISizeT "..%0*" _PRISizeT, AddrDigitsCount, base_display_addr, AddrDigitsCount, base_display_addr + mem_size - 1);
+  ImGui::Text("Range %0*" PRIX64 "..%0*" PRIX64, AddrDigitsCount, AddrOf(0), AddrDigitsCount, MaxAddr());
   ImGui::SameLine();
   ImGui::PushItemWidth((AddrDigitsCount + 1) * GlyphWidth + style.FramePadding.x * 2.0f);
   if (ImGui::InputText("##addr", AddrInputBuf, 32, ImGuiInputTextFlags_CharsHexadecimal | ImGuiInputTextFlags_EnterReturnsTrue))
   {
-    size_t goto_addr;
-    if (sscanf(AddrInputBuf, "%" _PRISizeT, &goto_addr) == 1)
+    uint64_t goto_addr;
+    if (sscanf(AddrInputBuf, "%" SCNx64, &goto_addr) == 1)
     {
-      GotoAddr = goto_addr - base_display_addr;
+      // addresses in a hole go to the next segment
+      size_t off;
+      OffsetOf(goto_addr, off);
+      GotoAddr = off;
     }
   }
   ImGui::PopItemWidth();
@@ -619,7 +1205,7 @@ void HexEdit::DrawHexEdit() {
     if (GotoAddr < mem_size)
     {
       ImGui::BeginChild("##scrolling");
-      ImGui::SetScrollFromPosY(ImGui::GetCursorStartPos().y + (GotoAddr / Columns) * LineHeight);
+      ScrollToRow(GotoAddr / Columns);
       ImGui::EndChild();
     }
     GotoAddr = (size_t)-1;
@@ -630,63 +1216,517 @@ void HexEdit::DrawHexEdit() {
 }
 
 void HexEdit::DrawHexView() {
+  size_t selected = m_views.indexOf(m_selected_view);
   ImGui::BeginChild("viewlist", ImVec2(ImGui::GetWindowContentRegionWidth() * 0.5f, m_height * 0.4f), false);
-  for (size_t n = 0; n < m_views.size(); n++)
-  {
-    char buf[sizeof(m_views[n].name) + 32];
-    snprintf(buf, sizeof(buf), "%0*" _PRISizeT " : %s", (int)AddrDigitsCount, m_views[n].start, m_views[n].name);
-    if (ImGui::Selectable(buf, n==m_selected_view))
-      m_selected_view = n;
+  ImGui::PushItemWidth(ImGui::GetContentRegionAvailWidth() * 0.5f);
+  if (ImGui::InputText("##filter", m_view_filter, sizeof(m_view_filter)))
+    m_view_list.setNeedle(m_view_filter);
+  ImGui::SameLine();
+  const char* sorts[] = { "start", "size", "name" };
+  int sort = m_view_list.sort();
+  if (ImGui::Combo("sort", &sort, sorts, IM_ARRAYSIZE(sorts)))
+    m_view_list.setSort(sort);
+  ImGui::PopItemWidth();
 
-    if (n==m_selected_view)
-      ImGui::SetItemDefaultFocus();
+  // only the rows on screen are drawn, the list can be as long as a search makes it
+  m_view_list.update(m_views);
+  const std::vector<ViewRow>& rows = m_view_list.rows();
+  ImGui::BeginChild("viewrows");
+  ImGuiListClipper clipper((int)rows.size());
+  while (clipper.Step()) {
+    for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+      const size_t n = rows[i].index;
+      const uint32_t id = m_views.id(n);
+      // a filtered list is flat
+      const bool tree_node = !m_view_list.filtered() && m_view_list.hasChildren(n);
+      ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_OpenOnDoubleClick |
+                                 ImGuiTreeNodeFlags_NoTreePushOnOpen;
+      if (!tree_node)
+        flags |= ImGuiTreeNodeFlags_Leaf;
+      if (n == selected)
+        flags |= ImGuiTreeNodeFlags_Selected;
+
+      ImGui::SetCursorPosX(ImGui::GetCursorPosX() + rows[i].depth * ImGui::GetStyle().IndentSpacing);
+      if (tree_node)
+        ImGui::SetNextTreeNodeOpen(m_view_list.isExpanded(id));
+      const bool open = ImGui::TreeNodeEx((void*)(intptr_t)id, flags, "%0*" PRIX64 " : %s", (int)AddrDigitsCount,
+                                          AddrOf(m_views.start(n)), m_views.name(n));
+      if (ImGui::IsItemClicked()) {
+        selected = n;
+        m_selected_view = id;
+      }
+      // the rows are only put together again by the next update
+      if (tree_node)
+        m_view_list.setExpanded(m_views, id, open);
+    }
   }
   ImGui::EndChild();
+  ImGui::EndChild();
 
   if(m_views.size()) {
-    if(m_selected_view >= m_views.size())
-      m_selected_view = 0;
+    if(selected >= m_views.size()) {
+      selected = 0;
+      m_selected_view = m_views.id(0);
+    }
 
     ImGui::SameLine();
 
     ImGui::BeginChild("vieweditor", ImVec2(0,m_height * 0.4f), false);
-    ImGui::InputText("name", m_views[m_selected_view].name, sizeof(m_views[m_selected_view].name));
-    ImGui::ColorEdit4("color", &m_views[m_selected_view].color.x);
-    ImGui::InputInt("start", (int*)&m_views[m_selected_view].start, 1, 16,
-                    ImGuiInputTextFlags_CharsHexadecimal | ImGuiInputTextFlags_EnterReturnsTrue);
-    ImGui::InputInt("end", (int*)&m_views[m_selected_view].end, 1, 16,
-                    ImGuiInputTextFlags_CharsHexadecimal | ImGuiInputTextFlags_EnterReturnsTrue);
+    // the views are edited through copies, imgui keeps the state of the inputs while they're active
+    char name[1024];
+    strncpy(name, m_views.name(selected), sizeof(name) - 1);
+    name[sizeof(name) - 1] = 0;
+    if (ImGui::InputText("name", name, sizeof(name))) {
+      m_views.setName(selected, name);
+      m_view_list.changed(m_views, selected);
+    }
+    ImVec4 color = ImGui::ColorConvertU32ToFloat4(m_views.color(selected));
+    if (ImGui::ColorEdit4("color", &color.x))
+      m_views.setColor(selected, ImGui::ColorConvertFloat4ToU32(color));
+    size_t start = m_views.start(selected), end = m_views.end(selected);
+    if (InputAddr("start", start)) {
+      m_views.setStart(selected, start);
+      m_view_list.changed(m_views, selected);
+    }
+    if (InputAddr("end", end)) {
+      m_views.setEnd(selected, end);
+      m_view_list.changed(m_views, selected);
+    }
 
     const char* items[] = { "Filled", "Line" };
-    int item_current;
-    switch(m_views[m_selected_view].mode) {
-      case HexViewMode_Filled: {
-        item_current = 0;
-        break;
-      }
-      case HexViewMode_Line: {
-        item_current = 1;
-        break;
-      }
+    int item_current = m_views.mode(selected);
+    if (ImGui::Combo("combo", &item_current, items, IM_ARRAYSIZE(items)))
+      m_views.setMode(selected, (HexViewMode)item_current);
+
+    ImGui::Text("size: %" PRIu64, m_views.end(selected) - (m_views.start(selected) - 1));
+    //todo: value
+    //ImGui::InputText("hexadecimal", 0,0, ImGuiInputTextFlags_CharsHexadecimal | ImGuiInputTextFlags_CharsUppercase);
+
+    // last, nothing uses the index afterwards
+    if (ImGui::Button("delete")) {
+      m_views.remove(selected);
+      m_selected_view = ViewStore::NoView;
     }
-    ImGui::Combo("combo", &item_current, items, IM_ARRAYSIZE(items));
-    switch(item_current) {
-      case 0: {
-        m_views[m_selected_view].mode = HexViewMode_Filled;
-        break;
-      }
-      case 1: {
-        m_views[m_selected_view].mode = HexViewMode_Line;
+
+    ImGui::EndChild();
+  }
+}
+
+// the whole text has to be a number
+static bool parseNumber(const char* text, long double& out) {
+  char* end;
+  out = strtold(text, &end);
+  while (*end == ' ')
+    end++;
+  return end != text && !*end;
+}
+
+std::shared_ptr<const search::Matcher> HexEdit::MakeMatcher() {
+  switch (m_search_mode) {
+  case SearchMode_Signatures: {
+    auto signatures = std::make_shared<search::SignatureSet>();
+    if (signatures->load(m_signature_path))
+      return signatures;
+    break;
+  }
+  case SearchMode_Number: {
+    search::NumberQuery query;
+    query.type = (search::NumberType)m_number_type;
+    query.endian = (search::Endian)m_number_endian;
+    query.align = (size_t)std::max(m_number_align, 1);
+    auto number = std::make_shared<search::NumberMatcher>();
+    if (parseNumber(m_number_text, query.value) && parseNumber(m_number_tolerance, query.tolerance) &&
+        parseNumber(m_number_scale, query.scale) && number->setup(query))
+      return number;
+    break;
+  }
+  case SearchMode_Bits: {
+    auto bits = std::make_shared<search::BitPatternMatcher>();
+    if (bits->parse(m_bits_text))
+      return bits;
+    break;
+  }
+  case SearchMode_Xor: {
+    std::vector<uint8_t> plain;
+    if (m_xor_hex) {
+      // the differences can't have wildcards
+      search::Pattern pattern;
+      if (!pattern.parse(m_xor_text) ||
+          std::any_of(pattern.mask(), pattern.mask() + pattern.size(), [](uint8_t m) { return m != 0xFF; }))
         break;
+      plain.assign(pattern.value(), pattern.value() + pattern.size());
+    } else {
+      plain.assign(m_xor_text, m_xor_text + strlen(m_xor_text));
+    }
+    auto xored = std::make_shared<search::XorMatcher>();
+    if (xored->setup(plain, (size_t)std::max(m_xor_key_length, 1)))
+      return xored;
+    break;
+  }
+  case SearchMode_Approximate: {
+    search::Pattern pattern;
+    auto approximate = std::make_shared<search::ApproximateMatcher>();
+    if (pattern.parse(m_search_text) && approximate->setup(pattern, (search::DistanceUnit)m_approx_unit,
+                                                            (uint32_t)std::max(m_approx_distance, 0)))
+      return approximate;
+    break;
+  }
+  default: {
+    search::Pattern pattern;
+    if (pattern.parse(m_search_text))
+      return std::make_shared<search::PatternMatcher>(pattern);
+    break;
+  }
+  }
+  return nullptr;
+}
+
+void HexEdit::UpdateSearchOrder() {
+  const std::vector<search::Hit>& hits = m_search.hits();
+  const size_t sorted = m_search_order.size();
+  if (!m_search.matcher() || !m_search.matcher()->ranked() || hits.size() == sorted)
+    return;
+
+  // the indices are in offset order already, so ties stay in offset order
+  auto by_tag = [&hits](uint32_t a, uint32_t b) { return hits[a].tag < hits[b].tag; };
+  for (size_t i = sorted; i < hits.size(); i++)
+    m_search_order.push_back((uint32_t)i);
+  std::stable_sort(m_search_order.begin() + sorted, m_search_order.end(), by_tag);
+  std::inplace_merge(m_search_order.begin(), m_search_order.begin() + sorted, m_search_order.end(), by_tag);
+}
+
+void HexEdit::DrawSearch() {
+  ImGuiStyle& style = ImGui::GetStyle();
+
+  ImGui::RadioButton("Bytes", &m_search_mode, SearchMode_Bytes);
+  ImGui::SameLine();
+  ImGui::RadioButton("Signature file", &m_search_mode, SearchMode_Signatures);
+  ImGui::SameLine();
+  ImGui::RadioButton("Number", &m_search_mode, SearchMode_Number);
+  ImGui::SameLine();
+  ImGui::RadioButton("Approximate", &m_search_mode, SearchMode_Approximate);
+  ImGui::SameLine();
+  ImGui::RadioButton("Bits", &m_search_mode, SearchMode_Bits);
+  ImGui::SameLine();
+  ImGui::RadioButton("XOR", &m_search_mode, SearchMode_Xor);
+
+  ImGui::PushItemWidth(-(ImGui::CalcTextSize("Cancel").x + style.FramePadding.x * 2.0f + style.ItemSpacing.x));
+  bool find;
+  switch (m_search_mode) {
+  case SearchMode_Signatures:
+    find = ImGui::InputText("##signatures", m_signature_path, sizeof(m_signature_path),
+                            ImGuiInputTextFlags_EnterReturnsTrue);
+    break;
+  case SearchMode_Number:
+    find = ImGui::InputText("##number", m_number_text, sizeof(m_number_text), ImGuiInputTextFlags_EnterReturnsTrue);
+    break;
+  case SearchMode_Bits:
+    find = ImGui::InputText("##bits", m_bits_text, sizeof(m_bits_text), ImGuiInputTextFlags_EnterReturnsTrue);
+    break;
+  case SearchMode_Xor:
+    find = ImGui::InputText("##xor", m_xor_text, sizeof(m_xor_text), ImGuiInputTextFlags_EnterReturnsTrue);
+    break;
+  default:
+    find = ImGui::InputText("##pattern", m_search_text, sizeof(m_search_text),
+                            ImGuiInputTextFlags_EnterReturnsTrue);
+    break;
+  }
+  ImGui::PopItemWidth();
+  ImGui::SameLine();
+  if (m_search.isRunning() || m_folder_search.isRunning()) {
+    if (ImGui::Button("Cancel")) {
+      m_search.cancel();
+      m_folder_search.cancel();
+    }
+  } else {
+    find |= ImGui::Button("Find");
+  }
+
+  if (m_search_mode == SearchMode_Number) {
+    ImGui::PushItemWidth(HexCellWidth * 4);
+    ImGui::Combo("type", &m_number_type, "u8\0i8\0u16\0i16\0u32\0i32\0u64\0i64\0float\0double\0");
+    ImGui::SameLine();
+    ImGui::Combo("endian", &m_number_endian, "little\0big\0both\0");
+    ImGui::SameLine();
+    ImGui::InputInt("align", &m_number_align, 0);
+    ImGui::InputText("+-", m_number_tolerance, sizeof(m_number_tolerance));
+    ImGui::SameLine();
+    // stored value * scale = value
+    ImGui::InputText("scale", m_number_scale, sizeof(m_number_scale));
+    ImGui::PopItemWidth();
+  } else if (m_search_mode == SearchMode_Approximate) {
+    ImGui::PushItemWidth(HexCellWidth * 4);
+    ImGui::InputInt("differing", &m_approx_distance, 1);
+    ImGui::SameLine();
+    ImGui::Combo("##unit", &m_approx_unit, "bytes\0bits\0");
+    ImGui::PopItemWidth();
+  } else if (m_search_mode == SearchMode_Xor) {
+    ImGui::Checkbox("hex", &m_xor_hex);
+    ImGui::SameLine();
+    ImGui::PushItemWidth(HexCellWidth * 4);
+    ImGui::InputInt("key bytes, at most", &m_xor_key_length, 1);
+    m_xor_key_length = std::min(std::max(m_xor_key_length, 1), (int)search::XorMatcher::MaxKeyLength);
+    ImGui::PopItemWidth();
+  }
+
+  ImGui::Checkbox("in folder", &m_search_folder);
+  if (m_search_folder) {
+    ImGui::SameLine();
+    ImGui::PushItemWidth(HexCellWidth * 16);
+    find |= ImGui::InputText("##folder", m_folder_path, sizeof(m_folder_path), ImGuiInputTextFlags_EnterReturnsTrue);
+    ImGui::PopItemWidth();
+    ImGui::SameLine();
+    ImGui::PushItemWidth(HexCellWidth * 3);
+    // with the dot, empty for all files
+    ImGui::InputText("extension", m_folder_extension, sizeof(m_folder_extension));
+    ImGui::PopItemWidth();
+  }
+
+  if (find && m_search_folder) {
+    std::shared_ptr<const search::Matcher> matcher = MakeMatcher();
+    m_search_invalid = !matcher;
+    if (matcher && !m_folder_search.start(m_folder_path, m_folder_extension, matcher))
+      LOG_WARN(std::string("no ") + m_folder_extension + " files in " + m_folder_path)
+  } else if (find && m_source) {
+    std::shared_ptr<const search::Matcher> matcher = MakeMatcher();
+    m_search_invalid = !matcher;
+    if (matcher) {
+      // the workers read the original data directly, the cache and the edit layer are only used by the ui
+      m_edit.endTyping();
+      // the index is of the file, edits could add matches anywhere
+      m_search.start(std::unique_ptr<io::DataSource>(new io::Snapshot(m_edit, m_source.get())), matcher,
+                     m_edit.isModified() ? nullptr : m_index);
+      m_search_selected = (size_t)-1;
+      m_search_order.clear();
+    }
+  }
+
+  if (m_search_invalid) {
+    if (m_search_mode == SearchMode_Signatures)
+      ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "one \"name = hex bytes\" per line, see the log");
+    else if (m_search_mode == SearchMode_Number)
+      ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "value, tolerance and scale have to be numbers");
+    else if (m_search_mode == SearchMode_Approximate)
+      ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "hex bytes (at most 64), ? for any nibble");
+    else if (m_search_mode == SearchMode_Bits)
+      ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "up to 57 bits of 0, 1 and ? (any bit): 1011 ??01");
+    else if (m_search_mode == SearchMode_Xor)
+      ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "at least 3 bytes, hex without wildcards");
+    else
+      ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "hex bytes, ? for any nibble: 4D 5A ?? 9?");
+  }
+
+  if (m_search_folder) {
+    DrawFolderResults();
+    return;
+  }
+
+  UpdateSearchOrder();
+  const std::vector<search::Hit>& hits = m_search.hits();
+  const bool ranked = m_search.matcher() && m_search.matcher()->ranked();
+  // the key is what's there xored with the plaintext, only the visible ones are worked out
+  auto xored = dynamic_cast<const search::XorMatcher*>(m_search.matcher());
+  ImGui::Text("%zu hits%s", hits.size(), m_search.truncated() ? ", stopped" : "");
+  if (m_search_selected < hits.size()) {
+    ImGui::SameLine();
+    if (ImGui::SmallButton("create view"))
+      AddHitView(hits[m_search_selected]);
+  }
+  ImGui::Separator();
+
+  ImGui::BeginChild("##hits");
+  ImGuiListClipper clipper((int)hits.size(), ImGui::GetTextLineHeightWithSpacing());
+  for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+    const size_t i = ranked ? m_search_order[row] : (size_t)row;
+    const search::Hit& hit = hits[i];
+    std::string label = m_search.matcher()->name(hit);
+    if (xored) {
+      std::vector<uint8_t> matched(hit.length);
+      matched.resize(m_edit.read(hit.offset, matched.data(), matched.size()));
+      if (matched.size() == hit.length)
+        label = "key " + xored->key(hit, matched.data());
+    }
+    char buf[1024];
+    snprintf(buf, sizeof(buf), "%0*" PRIX64 "  %s##%zu", (int)AddrDigitsCount, AddrOf(hit.offset), label.c_str(), i);
+    if (ImGui::Selectable(buf, m_search_selected == i)) {
+      // jump there and select the match
+      m_search_selected = i;
+      GotoAddr = hit.offset;
+      m_cursor = hit.offset;
+      m_cursor_low_nibble = false;
+      m_click_start = hit.offset;
+      m_click_current = hit.offset + hit.length - 1;
+    }
+  }
+  clipper.End();
+  ImGui::EndChild();
+}
+
+void HexEdit::DrawFolderResults() {
+  const std::vector<search::FileHits>& results = m_folder_search.results();
+  ImGui::Text("%zu hits in %zu of %zu files", m_folder_search.hitCount(), results.size(),
+              m_folder_search.fileCount());
+  if (m_folder_search.failedCount()) {
+    ImGui::SameLine();
+    ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%zu couldn't be opened", m_folder_search.failedCount());
+  }
+  if (m_folder_search.isRunning()) {
+    ImGui::SameLine();
+    ImGui::ProgressBar(m_folder_search.progress(), ImVec2(HexCellWidth * 4, 0), "searching");
+  }
+  ImGui::Separator();
+
+  ImGui::BeginChild("##files");
+  const search::Matcher* matcher = m_folder_search.matcher();
+  for (size_t f = 0; f < results.size(); f++) {
+    const search::FileHits& file = results[f];
+    const std::string name = fs::path(file.path).filename().string();
+    ImGui::PushID((int)f);
+    const bool open = ImGui::TreeNode("##file", "%s  %zu hits%s", name.c_str(), file.hits.size(),
+                                      file.truncated ? ", stopped" : "");
+    if (ImGui::IsItemHovered())
+      ImGui::SetTooltip("%s", file.path.c_str());
+    if (open) {
+      // a file has up to MaxFileHits of them
+      ImGuiListClipper clipper((int)file.hits.size(), ImGui::GetTextLineHeightWithSpacing());
+      for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+        const search::Hit& hit = file.hits[i];
+        char buf[1024];
+        snprintf(buf, sizeof(buf), "%08zX  %s##%d", hit.offset, matcher->name(hit), i);
+        if (ImGui::Selectable(buf))
+          OpenAt(file.path, hit.offset, hit.length);
       }
+      clipper.End();
+      ImGui::TreePop();
     }
+    ImGui::PopID();
+  }
+  ImGui::EndChild();
+}
 
-    ImGui::Text("size: %lu", m_views[m_selected_view].end - (m_views[m_selected_view].start - 1));
-    //todo: value
-    //ImGui::InputText("hexadecimal", 0,0, ImGuiInputTextFlags_CharsHexadecimal | ImGuiInputTextFlags_CharsUppercase);
+void HexEdit::DrawStrings() {
+  for (int i = 0; i < search::StringEncoding_COUNT; i++) {
+    ImGui::Checkbox(search::stringEncodingName(i), &m_strings_encodings[i]);
+    ImGui::SameLine();
+  }
+  ImGui::PushItemWidth(HexCellWidth * 4);
+  ImGui::InputInt("min chars", &m_strings_min_chars, 1);
+  m_strings_min_chars = std::max(m_strings_min_chars, 1);
+  ImGui::PopItemWidth();
+  ImGui::SameLine();
+  if (m_strings.isRunning()) {
+    if (ImGui::Button("Cancel"))
+      m_strings.cancel();
+  } else if (ImGui::Button("Extract") && m_source) {
+    unsigned encodings = 0;
+    for (int i = 0; i < search::StringEncoding_COUNT; i++)
+      encodings |= m_strings_encodings[i] ? 1u << i : 0u;
+    m_edit.endTyping();
+    m_strings.start(std::unique_ptr<io::DataSource>(new io::Snapshot(m_edit, m_source.get())), encodings,
+                    (size_t)m_strings_min_chars);
+    m_strings_filter.reset();
+    m_strings_selected = (size_t)-1;
+    m_strings_top = 0;
+  }
 
-    ImGui::EndChild();
+  // the filter works through a few megabytes of text per frame and catches up with new strings as they come
+  const search::StringList& strings = m_strings.strings();
+  ImGui::PushItemWidth(-1.0f);
+  ImGui::InputText("##filter", m_strings_filter_text, sizeof(m_strings_filter_text));
+  ImGui::PopItemWidth();
+  m_strings_filter.setNeedle(m_strings_filter_text);
+  const bool filtered = !m_strings_filter.empty();
+  const bool filtering = !m_strings_filter.update(strings, 4 * 1024 * 1024);
+  const size_t count = filtered ? m_strings_filter.matches().size() : strings.size();
+
+  if (filtered)
+    ImGui::Text("%zu of %zu strings%s", count, strings.size(), filtering ? ", filtering" : "");
+  else
+    ImGui::Text("%zu strings%s", count, m_strings.truncated() ? ", stopped" : "");
+  ImGui::Separator();
+
+  // drawn by row, imgui's float positions can't tell the rows of millions of strings apart
+  ImGuiStyle& style = ImGui::GetStyle();
+  const float row_height = ImGui::GetTextLineHeightWithSpacing();
+  ImGui::BeginChild("##strings", ImVec2(-style.ScrollbarSize, 0), false,
+                    ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse);
+  const float height = ImGui::GetWindowHeight();
+  const size_t visible_rows = std::max((size_t)1, (size_t)(height / row_height));
+  if (ImGui::IsWindowHovered() && ImGui::GetIO().MouseWheel != 0.0f) {
+    const int64_t rows = (int64_t)(-ImGui::GetIO().MouseWheel * 3.0f);
+    m_strings_top = (size_t)std::max((int64_t)0, (int64_t)m_strings_top + rows);
+  }
+  m_strings_top = std::min(m_strings_top, count > visible_rows ? count - visible_rows : 0);
+
+  std::vector<uint8_t> bytes;
+  std::string text;
+  for (size_t row = m_strings_top; row < std::min(count, m_strings_top + visible_rows); row++) {
+    const size_t i = filtered ? m_strings_filter.matches()[row] : row;
+    const size_t off = strings.offsets[i];
+    const size_t len = strings.lengths[i];
+
+    // only the start of long strings fits into the row anyway
+    bytes.resize(std::min(len, (size_t)256));
+    bytes.resize(m_edit.read(off, bytes.data(), bytes.size()));
+    text.clear();
+    search::decodeString(bytes.data(), bytes.size(), strings.encodings[i], text);
+
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%0*" PRIX64 "  %-8s  ", (int)AddrDigitsCount, AddrOf(off),
+             search::stringEncodingName(strings.encodings[i]));
+    text.insert(0, buf);
+
+    // the text isn't part of the label, a # in it would be taken for an id
+    const float x = ImGui::GetCursorPosX();
+    ImGui::PushID((int)row);
+    if (ImGui::Selectable("##string", m_strings_selected == i)) {
+      m_strings_selected = i;
+      GotoAddr = off;
+      m_cursor = off;
+      m_cursor_low_nibble = false;
+      m_click_start = off;
+      m_click_current = off + len - 1;
+    }
+    ImGui::PopID();
+    ImGui::SameLine(x);
+    ImGui::TextUnformatted(text.c_str(), text.c_str() + text.size());
+  }
+  ImGui::EndChild();
+
+  ImGui::SameLine(0, 0);
+  size_t top;
+  if (DrawScrollbar(height, count, m_strings_top, visible_rows, m_strings_grab, top))
+    m_strings_top = top;
+}
+
+void HexEdit::AddSearchViews() {
+  const search::Matcher* matcher = m_search.matcher();
+  if (!matcher || !matcher->addsViews())
+    return;
+
+  const std::vector<search::Hit>& hits = m_search.hits();
+  if (hits.size() > MaxSearchViews)
+    LOG_WARN("only the first " + std::to_string(MaxSearchViews) + " of " + std::to_string(hits.size()) +
+             " hits are added as views")
+
+  m_views.reserve(m_views.size() + std::min(hits.size(), MaxSearchViews));
+  for (size_t i = 0; i < std::min(hits.size(), MaxSearchViews); i++)
+    AddHitView(hits[i]);
+}
+
+void HexEdit::AddHitView(const search::Hit& hit) {
+  const search::Matcher* matcher = m_search.matcher();
+  char bits_name[64];
+  const char* name = bits_name;
+  if (auto bits = dynamic_cast<const search::BitPatternMatcher*>(matcher)) {
+    // the view can only cover whole bytes, the name tells which bits matched
+    snprintf(bits_name, sizeof(bits_name), "bits %" PRIX64 ".%u+%zu", AddrOf(hit.offset), hit.tag, bits->bits());
+  } else {
+    name = matcher->name(hit);
   }
+  // spread the hues, so every tag (signature, endianness, ...) gets its own colour
+  const ImU32 color = ImColor::HSV(std::fmod(hit.tag * 0.618034f, 1.0f), 0.6f, 0.6f);
+  m_views.add(hit.offset, hit.offset + hit.length - 1, name, color, HexViewMode_Filled);
 }
 
 void HexEdit::DrawHexGraph() {
@@ -732,4 +1772,3 @@ void HexEdit::DrawHexTable() {
   }
 }
 
-#undef _PRISizeT
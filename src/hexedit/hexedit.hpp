@@ -10,26 +10,32 @@
 #include <vector>
 #include <tuple>
 #include <functional>
+#include <memory>
 #include "json.hpp"
 #include "opengl/glclasses.hpp"
+#include "io/datasource.hpp"
+#include "io/pagecache.hpp"
+#include "io/piecetable.hpp"
+#include "io/loader.hpp"
+#include "io/segmentmap.hpp"
+#include "search/search.hpp"
+#include "search/numeric.hpp"
+#include "search/approximate.hpp"
+#include "search/bits.hpp"
+#include "search/xor.hpp"
+#include "search/indexer.hpp"
+#include "search/strings.hpp"
+#include "search/foldersearch.hpp"
+#include "viewindex.hpp"
+#include "viewstore.hpp"
+#include "viewlist.hpp"
 
 using json = nlohmann::json;
 
-enum HexViewMode { HexViewMode_Filled, HexViewMode_Line };
-
-struct HexView {
-  size_t id;
-  char name[1024];
-  size_t start, end;
-  HexViewMode mode = HexViewMode_Filled;
-  ImVec4 color;
+enum SearchMode {
+  SearchMode_Bytes, SearchMode_Signatures, SearchMode_Number, SearchMode_Approximate, SearchMode_Bits, SearchMode_Xor
 };
 
-inline bool operator< (const HexView& lhs, const HexView& rhs){ return lhs.start < rhs.start; }
-inline bool operator> (const HexView& lhs, const HexView& rhs){ return rhs < lhs; }
-inline bool operator<=(const HexView& lhs, const HexView& rhs){ return !(lhs > rhs); }
-inline bool operator>=(const HexView& lhs, const HexView& rhs){ return !(lhs < rhs); }
-
 struct HexEdit {
 private:
   // current width/height
@@ -52,39 +58,155 @@ private:
 
   // used for view selection
   bool m_clicked = false;
-  size_t m_click_start, m_click_current;
-  size_t m_selected_view = 0;
+  // the selected bytes, both -1 while nothing is selected
+  size_t m_click_start = (size_t)-1, m_click_current = (size_t)-1;
+  // id of the view being edited
+  uint32_t m_selected_view = ViewStore::NoView;
+  // index of the view under the mouse
   int m_current_view = -1;
+  // interval tree over m_views, it's rebuilt when they were changed
+  ViewIndex m_view_index;
+  size_t m_view_index_version = (size_t)-1;
+  // sorted and filtered rows of the view list
+  ViewList m_view_list;
+  char m_view_filter[128] = "";
+
+  // geometry of the view highlights, reused every frame
+  struct HighlightRect {
+    ImVec2 min, max;
+    ImU32 color;
+  };
+  std::vector<uint32_t> m_visible_views;
+  // ids of the parents of the visible views
+  std::vector<uint32_t> m_covered_views;
+  // the rects are drawn whenever this many are collected, the draw list has 32 bit indices so there's no limit
+  std::vector<HighlightRect> m_highlight_rects;
+  static const size_t HighlightBatch = 8192;
   size_t m_cursor = 0;
+  bool m_cursor_low_nibble = false;
+
+  // the loaded data, the page cache in front of it and the edits on top
+  std::unique_ptr<io::DataSource> m_source;
+  std::string m_file_path;
+  io::Loader m_loader;
+  // addresses of sparse sources, empty if the data is contiguous from base_display_addr
+  io::SegmentMap m_segments;
+  io::PageCache m_cache;
+  io::PieceTable m_edit;
+  int m_cache_budget_mb = 64;
+  size_t m_prefetch_addr = (size_t)-1;
+  // when the memory map of an attached process was read last, it's read again every second
+  float m_process_refresh_time = 0.0f;
+
+  // imgui lays out in float pixels, which can't address every row of a big file. only a window of rows around
+  // the current position is put into the scrolling region, it's moved along when the position gets close to
+  // its edges. the scrollbar is drawn separately and covers all rows
+  static const size_t WindowRows = 1 << 16;
+  size_t m_window_base = 0;
+  // next window base, it's applied in the frame the matching scroll position takes effect
+  size_t m_pending_base = (size_t)-1;
+  // distance of the mouse to the top of the scrollbar grab while it's dragged
+  float m_scrollbar_grab = -1.0f;
+
+  // byte pattern search, it runs on worker threads over a snapshot of the edited data
+  search::Search m_search;
+  bool m_show_search = false;
+  int m_search_mode = SearchMode_Bytes;
+  bool m_search_invalid = false;
+  char m_search_text[256] = "";
+  // file with the signatures for SearchMode_Signatures
+  char m_signature_path[1024] = "";
+  // typed number for SearchMode_Number
+  char m_number_text[64] = "";
+  char m_number_tolerance[32] = "0";
+  char m_number_scale[32] = "1";
+  int m_number_type = search::NumberType_U32;
+  int m_number_endian = search::Endian_Little;
+  int m_number_align = 1;
+  // SearchMode_Approximate takes the pattern of SearchMode_Bytes
+  int m_approx_distance = 1;
+  int m_approx_unit = search::DistanceUnit_Bytes;
+  // bit pattern for SearchMode_Bits
+  char m_bits_text[128] = "";
+  // plaintext for SearchMode_Xor, as text or hex bytes
+  char m_xor_text[256] = "";
+  bool m_xor_hex = false;
+  int m_xor_key_length = 1;
+  // hit indices by tag, for matchers whose hits are ranked. new hits are merged in as they come
+  std::vector<uint32_t> m_search_order;
+  // a search doesn't add more views than that, the rest of the hits is in the search window
+  static const size_t MaxSearchViews = 100000;
+  // index into the hits
+  size_t m_search_selected = (size_t)-1;
+  // the same search over every file in a folder, the files are mapped instead of opened
+  search::FolderSearch m_folder_search;
+  bool m_search_folder = false;
+  char m_folder_path[1024] = "";
+  char m_folder_extension[32] = ".bin";
+  // what's selected once a file opened from the folder results is loaded, -1 if nothing
+  size_t m_open_offset = (size_t)-1;
+  size_t m_open_length = 0;
+  // trigram index of the file, kept beside the project file. it's only used while there are no edits
+  search::Indexer m_indexer;
+  std::shared_ptr<const search::BlockIndex> m_index;
+
+  // printable strings of the data, extracted on worker threads over a snapshot like the search
+  search::StringExtractor m_strings;
+  search::StringFilter m_strings_filter;
+  bool m_show_strings = false;
+  bool m_strings_encodings[search::StringEncoding_COUNT] = {true, true, false, false};
+  int m_strings_min_chars = 4;
+  char m_strings_filter_text[128] = "";
+  // the list can hold millions of rows, it's scrolled by row like the hex pane instead of by pixel
+  size_t m_strings_top = 0;
+  float m_strings_grab = -1.0f;
+  // index into the strings
+  size_t m_strings_selected = (size_t)-1;
+
+  // bytes of the line currently being rendered
+  std::vector<uint8_t> m_line_buf;
 
   std::vector<float> data_X;
   std::vector<float> data_Y;
   std::vector<float> data;
 
-  size_t getRow(size_t addr);
-  size_t getCol(size_t addr);
-  // returns upper left x
-  float getTopX(size_t addr);
-  // returns upper left y
-  float getTopY(size_t addr);
-  // returns lower right x
-  float getBottomX(size_t addr);
-  // returns lower right y
-  float getBottomY(size_t addr);
+  // the innermost view containing addr, -1 if there's none
+  int ViewAt(size_t addr);
+  void UpdateViewIndex();
+  // id of the innermost view containing start..end, NoView if there's none
+  uint32_t ViewAround(size_t start, size_t end);
+
+  size_t RowCount() const;
+  // scrolls so row is at the top (plus pixel_offset), has to be called inside the scrolling region
+  void ScrollToRow(size_t row, float pixel_offset = 0.0f);
+  // virtual scrollbar over all rows, returns true and the new top row if it was moved
+  // grab is where the mouse holds the grab while it's dragged, -1 otherwise
+  bool DrawScrollbar(float height, size_t total, size_t top_row, size_t visible_rows, float& grab, size_t& row);
 
-  int isHighlighted(size_t addr);
+  // translate between data offsets and the displayed addresses
+  uint64_t AddrOf(size_t off) const;
+  bool OffsetOf(uint64_t addr, size_t& off) const;
+  uint64_t MaxAddr() const;
+  // hex input for an address, off is updated on enter
+  bool InputAddr(const char* label, size_t& off);
+
+  // true if bytes of the data are selected
+  bool HasSelection() const;
+  void ClearSelection();
+
+  // cursor movement & typing into the hex column
+  void HandleEditKeys();
 
 public:
   // all the current views
-  std::vector<HexView> m_views;
+  ViewStore m_views;
 
   // path for storing views
   std::string project_path;
 
   // data
-  uint8_t* mem_data = NULL;
   size_t mem_size = 0;
-  size_t base_display_addr = 0;
+  uint64_t base_display_addr = 0;
 
   // original memory editor settings
   // todo: refactor
@@ -93,11 +215,16 @@ public:
   int             Columns;            //
   bool            OptShowAscii;       //
   bool            OptGreyOutZeroes;   //
+  bool            OptInsertMode;      // typing inserts bytes instead of overwriting them
+  bool            OptReadAhead;       // read the whole file into the os page cache in the background after opening
+  bool            OptParseFirmware;   // open Intel HEX, S-record and ELF files as the memory they describe
   int             OptMidColumnsCount; // set to 0 to disable extra spacing between every mid-rows
   int             OptAddrDigitsCount; // number of addr digits to display (default calculated based on maximum displayed addr)
 
-  std::function<uint8_t(uint8_t* data, size_t off)> ReadFn;
-  std::function<void(uint8_t* data, size_t off, uint8_t d)> WriteFn;
+  // copies up to len bytes at off into dst, returns the number of bytes read
+  std::function<size_t(size_t off, uint8_t* dst, size_t len)> ReadFn;
+  // overwrites the byte at off
+  std::function<void(size_t off, uint8_t d)> WriteFn;
 
   bool            ContentsWidthChanged;
   char            DataInputBuf[32];
@@ -106,12 +233,32 @@ public:
 
   HexEdit();
 
+  // starts loading the file in the background
   void LoadFile(const char* path);
+  // takes over the file once the loader opened it
+  void PollLoader();
+  // shows the live memory of a local process
+  void AttachProcess(int pid);
+  // reads the memory map of the attached process again, the edits and results are dropped if it changed
+  void RefreshProcess();
+  // displays source, path is where edits are saved to (empty if they can't be saved)
+  void SetSource(std::unique_ptr<io::DataSource> source, const std::string& path);
+  void CloseFile();
+  // writes the edits back to the loaded file
+  void SaveFile();
   void LoadProject();
   void Save();
 
   void CalcSizes();
 
+  // editing, all of it can be undone
+  void Undo();
+  void Redo();
+  // overwrites the current selection with value, if there's one
+  void FillSelection(uint8_t value);
+  // parses text as hex bytes and writes them at the cursor
+  void PasteHex(const char* text);
+
   // creates everything ( hexedit, view & graph )
   void BeginWindow(const char *title, size_t w, size_t h, size_t m_delta);
 
@@ -125,4 +272,22 @@ public:
   void DrawHexGraph();
   // render the table
   void DrawHexTable();
+  // renders the search window
+  void DrawSearch();
+  // the files with hits of the folder search, as a tree
+  void DrawFolderResults();
+  // opens the file at path as it is (no firmware parsing, the offsets are of the raw file) and selects len bytes
+  // at off once it's loaded
+  void OpenAt(const std::string& path, size_t off, size_t len);
+  // renders the strings window
+  void DrawStrings();
+  // turns the hits of a finished search into views, if its matcher wants that
+  void AddSearchViews();
+  void AddHitView(const search::Hit& hit);
+  void UpdateSearchOrder();
+  // where the index of the open file is stored, empty if it can't have one
+  std::string IndexPath() const;
+  void BuildIndex();
+  // what DrawSearch's input describes, NULL if it's invalid
+  std::shared_ptr<const search::Matcher> MakeMatcher();
 };
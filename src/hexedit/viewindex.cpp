@@ -0,0 +1,61 @@
+#include "viewindex.hpp"
+#include <algorithm>
+
+void ViewIndex::clear() {
+  m_items.clear();
+  m_max_end.clear();
+}
+
+void ViewIndex::add(size_t start, size_t end, uint32_t id) {
+  m_items.push_back(Interval{start, end, id});
+}
+
+void ViewIndex::build() {
+  // stable, so ranges with the same start stay in the order they were added in
+  std::stable_sort(m_items.begin(), m_items.end(), [](const Interval& a, const Interval& b) {
+    return a.start < b.start;
+  });
+  m_max_end.resize(m_items.size());
+  buildMax(0, m_items.size());
+}
+
+size_t ViewIndex::buildMax(size_t lo, size_t hi) {
+  if(lo >= hi)
+    return 0;
+  const size_t mid = lo + (hi - lo) / 2;
+  m_max_end[mid] = std::max(m_items[mid].end, std::max(buildMax(lo, mid), buildMax(mid + 1, hi)));
+  return m_max_end[mid];
+}
+
+template<typename F>
+void ViewIndex::visit(size_t first, size_t last, size_t lo, size_t hi, F& f) const {
+  while(lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    // nothing below reaches first
+    if(m_max_end[mid] < first)
+      return;
+    visit(first, last, lo, mid, f);
+    // everything right of mid starts after last
+    if(m_items[mid].start > last)
+      return;
+    if(m_items[mid].end >= first)
+      f(m_items[mid]);
+    lo = mid + 1;
+  }
+}
+
+int64_t ViewIndex::innermost(size_t addr) const {
+  const Interval* best = nullptr;
+  auto f = [&best](const Interval& item) {
+    if(!best || item.end - item.start < best->end - best->start ||
+       (item.end - item.start == best->end - best->start && item.id < best->id))
+      best = &item;
+  };
+  visit(addr, addr, 0, m_items.size(), f);
+  return best ? (int64_t)best->id : -1;
+}
+
+void ViewIndex::overlapping(size_t first, size_t last, std::vector<uint32_t>& out) const {
+  auto f = [&out](const Interval& item) { out.push_back(item.id); };
+  visit(first, last, 0, m_items.size(), f);
+}
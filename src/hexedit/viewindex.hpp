@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/*
+ * interval tree over the address ranges of the views, for finding the views at an address or in a range in
+ * O(log n + k) instead of going through all of them.
+ *
+ * the ranges are kept sorted by start and the tree is implicit: the middle of every range of the array is the
+ * root of the subtree over it, it also holds the biggest end in that subtree. ranges are added all at once and
+ * the tree is built by build(), changing the views means building it again (which is O(n log n)).
+ * */
+class ViewIndex {
+private:
+  struct Interval {
+    size_t start;
+    // inclusive, like the end of a view
+    size_t end;
+    uint32_t id;
+  };
+
+  std::vector<Interval> m_items;
+  // biggest end in the subtree whose root is at the same index
+  std::vector<size_t> m_max_end;
+
+  size_t buildMax(size_t lo, size_t hi);
+  template<typename F>
+  void visit(size_t first, size_t last, size_t lo, size_t hi, F& f) const;
+
+public:
+  void clear();
+  void add(size_t start, size_t end, uint32_t id);
+  // has to be called after adding and before querying
+  void build();
+
+  size_t size() const { return m_items.size(); }
+
+  // the id of the smallest range containing addr (the lowest id if several are as small), -1 if there's none
+  int64_t innermost(size_t addr) const;
+  // appends the ids of the ranges which overlap [first, last], in the order of their start
+  void overlapping(size_t first, size_t last, std::vector<uint32_t>& out) const;
+};
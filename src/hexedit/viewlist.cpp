@@ -0,0 +1,238 @@
+#include "viewlist.hpp"
+#include <algorithm>
+#include <numeric>
+#include <string.h>
+
+static char lower(char c) {
+  return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+void ViewList::clear() {
+  m_children.clear();
+  // the roots are collected again by the next update
+  m_removals = (size_t)-1;
+}
+
+void ViewList::setSort(int sort) {
+  if(sort == m_sort)
+    return;
+  m_sort = sort;
+  // sorted again by the next update
+  m_removals = (size_t)-1;
+}
+
+void ViewList::setNeedle(const std::string& needle) {
+  std::string lowered = needle;
+  for(char& c : lowered)
+    c = lower(c);
+  if(lowered == m_needle)
+    return;
+  m_needle = lowered;
+  m_rematch = true;
+}
+
+bool ViewList::less(const ViewStore& views, uint32_t a, uint32_t b) const {
+  switch(m_sort) {
+    case ViewSort_Size: {
+      const uint64_t size_a = views.end(a) - views.start(a), size_b = views.end(b) - views.start(b);
+      if(size_a != size_b)
+        return size_a < size_b;
+      break;
+    }
+    case ViewSort_Name: {
+      // views with the same name share it
+      const char* name_a = views.name(a);
+      const char* name_b = views.name(b);
+      const int cmp = name_a == name_b ? 0 : strcmp(name_a, name_b);
+      if(cmp != 0)
+        return cmp < 0;
+      break;
+    }
+    default:
+      if(views.start(a) != views.start(b))
+        return views.start(a) < views.start(b);
+      break;
+  }
+  // the order of adding
+  return a < b;
+}
+
+bool ViewList::matches(const ViewStore& views, size_t index) const {
+  const char* name = views.name(index);
+  for(; *name; name++) {
+    size_t i = 0;
+    while(i < m_needle.size() && lower(name[i]) == m_needle[i])
+      i++;
+    if(i == m_needle.size())
+      return true;
+  }
+  return m_needle.empty();
+}
+
+void ViewList::rebuild(const ViewStore& views) {
+  const size_t n = views.size();
+  m_order.resize(n);
+  std::iota(m_order.begin(), m_order.end(), 0);
+  std::sort(m_order.begin(), m_order.end(), [&](uint32_t a, uint32_t b) { return less(views, a, b); });
+
+  m_matches.resize(n);
+  for(size_t i = 0; i < n; i++)
+    m_matches[i] = matches(views, i);
+
+  m_has_children.assign(n, false);
+  for(size_t i = 0; i < n; i++) {
+    const uint32_t parent = views.indexOf(views.parent(i));
+    if(parent != ViewStore::NoView)
+      m_has_children[parent] = true;
+  }
+
+  // removed views can't be expanded anymore
+  for(auto it = m_children.begin(); it != m_children.end();) {
+    if(it->first != ViewStore::NoView && views.indexOf(it->first) == ViewStore::NoView)
+      it = m_children.erase(it);
+    else
+      ++it;
+  }
+  collectChildren(views);
+
+  m_count = n;
+  m_removals = views.removals();
+  m_by_parent_dirty = true;
+  m_rematch = false;
+  m_rows_dirty = true;
+}
+
+void ViewList::append(const ViewStore& views) {
+  const size_t n = views.size();
+  const size_t first = m_count;
+  auto less_fnc = [&](uint32_t a, uint32_t b) { return less(views, a, b); };
+
+  // the new views are sorted on their own and merged in
+  m_order.resize(n);
+  std::iota(m_order.begin() + first, m_order.end(), (uint32_t)first);
+  std::sort(m_order.begin() + first, m_order.end(), less_fnc);
+
+  m_matches.resize(n);
+  m_has_children.resize(n, false);
+  // where the children lists of the expanded views ended before
+  std::unordered_map<uint32_t, size_t> merge_at;
+  for(auto it = m_order.begin() + first; it != m_order.end(); ++it) {
+    const uint32_t index = *it;
+    m_matches[index] = matches(views, index);
+    const uint32_t parent = views.parent(index);
+    if(parent != ViewStore::NoView && views.indexOf(parent) != ViewStore::NoView)
+      m_has_children[views.indexOf(parent)] = true;
+
+    auto children = m_children.find(parent);
+    if(children == m_children.end())
+      continue;
+    merge_at.insert(std::make_pair(parent, children->second.size()));
+    children->second.push_back(index);
+  }
+
+  std::inplace_merge(m_order.begin(), m_order.begin() + first, m_order.end(), less_fnc);
+  for(auto& at : merge_at) {
+    auto& children = m_children[at.first];
+    std::inplace_merge(children.begin(), children.begin() + at.second, children.end(), less_fnc);
+  }
+
+  m_count = n;
+  m_by_parent_dirty = true;
+  m_rows_dirty = true;
+}
+
+void ViewList::collectChildren(const ViewStore& views) {
+  m_children[ViewStore::NoView];
+  for(auto& children : m_children)
+    children.second.clear();
+  // in sorted order, so the lists are sorted too
+  for(uint32_t index : m_order) {
+    auto children = m_children.find(views.parent(index));
+    if(children != m_children.end())
+      children->second.push_back(index);
+  }
+}
+
+void ViewList::addRows(const ViewStore& views, uint32_t id, uint32_t depth) {
+  for(uint32_t index : m_children[id]) {
+    m_rows.push_back(ViewRow{index, depth});
+    if(m_has_children[index] && isExpanded(views.id(index)))
+      addRows(views, views.id(index), depth + 1);
+  }
+}
+
+void ViewList::update(const ViewStore& views) {
+  if(views.removals() != m_removals) {
+    rebuild(views);
+  } else if(views.size() != m_count) {
+    append(views);
+  }
+
+  if(m_rematch) {
+    for(size_t i = 0; i < m_count; i++)
+      m_matches[i] = matches(views, i);
+    m_rematch = false;
+    m_rows_dirty = true;
+  }
+
+  if(!m_rows_dirty)
+    return;
+  m_rows.clear();
+  if(filtered()) {
+    for(uint32_t index : m_order) {
+      if(m_matches[index])
+        m_rows.push_back(ViewRow{index, 0});
+    }
+  } else {
+    addRows(views, ViewStore::NoView, 0);
+  }
+  m_rows_dirty = false;
+}
+
+void ViewList::changed(const ViewStore& views, size_t index) {
+  // views which weren't sorted in yet are done by the next update
+  if(index >= m_count)
+    return;
+
+  auto less_fnc = [&](uint32_t a, uint32_t b) { return less(views, a, b); };
+  // the rest is still sorted, the view is taken out and put back at its new place
+  auto move = [&](std::vector<uint32_t>& list) {
+    auto it = std::find(list.begin(), list.end(), (uint32_t)index);
+    if(it == list.end())
+      return;
+    list.erase(it);
+    list.insert(std::upper_bound(list.begin(), list.end(), (uint32_t)index, less_fnc), (uint32_t)index);
+  };
+  move(m_order);
+  auto children = m_children.find(views.parent(index));
+  if(children != m_children.end())
+    move(children->second);
+
+  m_matches[index] = matches(views, index);
+  m_by_parent_dirty = true;
+  m_rows_dirty = true;
+}
+
+void ViewList::setExpanded(const ViewStore& views, uint32_t id, bool expanded) {
+  if(expanded == isExpanded(id))
+    return;
+  m_rows_dirty = true;
+  if(!expanded) {
+    m_children.erase(id);
+    return;
+  }
+
+  if(m_by_parent_dirty) {
+    // stable, so the children stay in sorted order
+    m_by_parent = m_order;
+    std::stable_sort(m_by_parent.begin(), m_by_parent.end(),
+                     [&](uint32_t a, uint32_t b) { return views.parent(a) < views.parent(b); });
+    m_by_parent_dirty = false;
+  }
+
+  auto first = std::lower_bound(m_by_parent.begin(), m_by_parent.end(), id,
+                                [&](uint32_t index, uint32_t parent) { return views.parent(index) < parent; });
+  auto last = std::upper_bound(first, m_by_parent.end(), id,
+                               [&](uint32_t parent, uint32_t index) { return parent < views.parent(index); });
+  m_children[id].assign(first, last);
+}
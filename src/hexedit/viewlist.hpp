@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "viewstore.hpp"
+
+enum ViewSort { ViewSort_Start, ViewSort_Size, ViewSort_Name };
+
+// a line of the view list
+struct ViewRow {
+  uint32_t index;
+  uint32_t depth;
+};
+
+/*
+ * the rows of the view list: the views sorted by start, size or name, as a tree of the expanded views or, while
+ * there's a filter, as the flat list of the views whose name contains it.
+ *
+ * the sorted order of all views is kept between frames. appended views are sorted on their own and merged in,
+ * a changed view is moved to its new place, everything is only sorted again when the sort changes or views were
+ * removed. the children of a view are only collected while it's expanded. the rows are put together from that in
+ * one pass when something changed, so they can be drawn with a clipper.
+ * */
+class ViewList {
+private:
+  int m_sort = ViewSort_Start;
+  // lowercase
+  std::string m_needle;
+
+  // indices of all views, sorted
+  std::vector<uint32_t> m_order;
+  // whether the name of the view at an index contains the needle
+  std::vector<bool> m_matches;
+  std::vector<bool> m_has_children;
+  // sorted indices of the children of the expanded views by their id, NoView for the roots
+  std::unordered_map<uint32_t, std::vector<uint32_t>> m_children;
+  // m_order grouped by the parent ids, so expanding a view doesn't go through all views. it's made again for the
+  // next expand once the order changed
+  std::vector<uint32_t> m_by_parent;
+  bool m_by_parent_dirty = true;
+
+  // the views the order was made from, the ones after m_count were appended since
+  size_t m_count = 0;
+  size_t m_removals = (size_t)-1;
+  bool m_rematch = false;
+
+  std::vector<ViewRow> m_rows;
+  bool m_rows_dirty = true;
+
+  bool less(const ViewStore& views, uint32_t a, uint32_t b) const;
+  bool matches(const ViewStore& views, size_t index) const;
+  void rebuild(const ViewStore& views);
+  void append(const ViewStore& views);
+  void collectChildren(const ViewStore& views);
+  void addRows(const ViewStore& views, uint32_t id, uint32_t depth);
+
+public:
+  // collapses all views, for a new list of views
+  void clear();
+  void setSort(int sort);
+  int sort() const { return m_sort; }
+  // sets the filter text, views are matched case insensitively
+  void setNeedle(const std::string& needle);
+  bool filtered() const { return !m_needle.empty(); }
+
+  // has to be called before the rows are used (every frame), catches up with the views
+  void update(const ViewStore& views);
+  // the name, start or end of the view at index was changed
+  void changed(const ViewStore& views, size_t index);
+
+  bool isExpanded(uint32_t id) const { return m_children.count(id) != 0; }
+  void setExpanded(const ViewStore& views, uint32_t id, bool expanded);
+  bool hasChildren(size_t index) const { return m_has_children[index]; }
+
+  const std::vector<ViewRow>& rows() const { return m_rows; }
+};
@@ -0,0 +1,129 @@
+#include "viewstore.hpp"
+#include <string.h>
+#include <algorithm>
+
+const uint32_t ViewStore::NoView;
+
+// FNV-1a
+size_t ViewStore::NameHash::operator()(uint32_t off) const {
+  size_t h = 14695981039346656037ull;
+  for(const char* c = &(*names)[off]; *c; c++)
+    h = (h ^ (uint8_t)*c) * 1099511628211ull;
+  return h;
+}
+
+bool ViewStore::NameEqual::operator()(uint32_t a, uint32_t b) const {
+  return a == b || strcmp(&(*names)[a], &(*names)[b]) == 0;
+}
+
+ViewStore::ViewStore() : m_interned(16, NameHash{&m_names}, NameEqual{&m_names}) {
+}
+
+void ViewStore::clear() {
+  m_start.clear();
+  m_end.clear();
+  m_color.clear();
+  m_mode.clear();
+  m_name.clear();
+  m_id.clear();
+  m_parent.clear();
+  m_index_of.clear();
+  m_names.clear();
+  m_interned.clear();
+  m_unused_names = 0;
+  m_version++;
+  m_removals++;
+}
+
+void ViewStore::reserve(size_t count) {
+  m_start.reserve(count);
+  m_end.reserve(count);
+  m_color.reserve(count);
+  m_mode.reserve(count);
+  m_name.reserve(count);
+  m_id.reserve(count);
+  m_parent.reserve(count);
+  m_index_of.reserve(count);
+}
+
+uint32_t ViewStore::intern(const char* name) {
+  // the name is appended to look it up, it's taken back out if it's there already
+  const uint32_t off = (uint32_t)m_names.size();
+  m_names.insert(m_names.end(), name, name + strlen(name) + 1);
+  auto it = m_interned.find(off);
+  if(it != m_interned.end()) {
+    m_names.resize(off);
+    return *it;
+  }
+  m_interned.insert(off);
+  return off;
+}
+
+uint32_t ViewStore::add(uint64_t start, uint64_t end, const char* name, uint32_t color, HexViewMode mode,
+                        uint32_t parent) {
+  const uint32_t id = (uint32_t)m_index_of.size();
+  m_index_of.push_back((uint32_t)m_start.size());
+  m_start.push_back(start);
+  m_end.push_back(end);
+  m_color.push_back(color);
+  m_mode.push_back((uint8_t)mode);
+  m_name.push_back(intern(name));
+  m_id.push_back(id);
+  m_parent.push_back(parent);
+  m_version++;
+  return id;
+}
+
+void ViewStore::remove(size_t index) {
+  // the name might be shared, whether it's unused is only known when compacting
+  m_unused_names += strlen(name(index)) + 1;
+  const uint32_t id = m_id[index];
+  const uint32_t parent = m_parent[index];
+  m_index_of[id] = NoView;
+
+  m_start.erase(m_start.begin() + index);
+  m_end.erase(m_end.begin() + index);
+  m_color.erase(m_color.begin() + index);
+  m_mode.erase(m_mode.begin() + index);
+  m_name.erase(m_name.begin() + index);
+  m_id.erase(m_id.begin() + index);
+  m_parent.erase(m_parent.begin() + index);
+  // the children come after the view, the grandparent before it
+  for(size_t i = index; i < m_id.size(); i++) {
+    m_index_of[m_id[i]] = (uint32_t)i;
+    if(m_parent[i] == id)
+      m_parent[i] = parent;
+  }
+  m_version++;
+  m_removals++;
+
+  if(m_unused_names > m_names.size() / 2)
+    compactNames();
+}
+
+void ViewStore::setName(size_t index, const char* name) {
+  if(strcmp(this->name(index), name) == 0)
+    return;
+  m_unused_names += strlen(this->name(index)) + 1;
+  m_name[index] = intern(name);
+
+  if(m_unused_names > m_names.size() / 2)
+    compactNames();
+}
+
+void ViewStore::compactNames() {
+  std::vector<char> old;
+  old.swap(m_names);
+  m_interned.clear();
+  m_unused_names = 0;
+  for(size_t i = 0; i < m_name.size(); i++)
+    m_name[i] = intern(&old[m_name[i]]);
+}
+
+size_t ViewStore::memoryUsage() const {
+  return m_start.capacity() * sizeof(uint64_t) + m_end.capacity() * sizeof(uint64_t) +
+         m_color.capacity() * sizeof(uint32_t) + m_mode.capacity() + m_name.capacity() * sizeof(uint32_t) +
+         m_id.capacity() * sizeof(uint32_t) + m_parent.capacity() * sizeof(uint32_t) +
+         m_index_of.capacity() * sizeof(uint32_t) + m_names.capacity() +
+         m_interned.bucket_count() * sizeof(void*) + m_interned.size() * (sizeof(uint32_t) + 2 * sizeof(void*));
+}
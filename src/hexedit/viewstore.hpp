@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+enum HexViewMode { HexViewMode_Filled, HexViewMode_Line };
+
+/*
+ * the views, stored as parallel arrays so a million of them (search hits, parsed records) take tens of
+ * megabytes: about 35 bytes a view plus its name.
+ *
+ * the names are interned in one arena, views with the same name (all the hits of a signature) share it. renamed
+ * views leave their old name behind, the arena is compacted once that's more than half of it.
+ *
+ * views are addressed by their position in the list, which changes when views before them are removed. every
+ * view also gets an id when it's added, it stays the same until the view is removed and isn't used again until
+ * the store is cleared.
+ *
+ * views can be nested (file, section, record, field), every view knows the id of its parent. a parent always comes
+ * before its children in the list, so walking up from a view ends at a root.
+ * */
+class ViewStore {
+private:
+  std::vector<uint64_t> m_start;
+  // inclusive
+  std::vector<uint64_t> m_end;
+  // ImU32, packed like imgui does
+  std::vector<uint32_t> m_color;
+  std::vector<uint8_t> m_mode;
+  // offset of the 0 terminated name in m_names
+  std::vector<uint32_t> m_name;
+  std::vector<uint32_t> m_id;
+  // id of the parent, NoView for the roots
+  std::vector<uint32_t> m_parent;
+  // position of every id ever handed out, NoView for removed ones
+  std::vector<uint32_t> m_index_of;
+
+  std::vector<char> m_names;
+  size_t m_unused_names = 0;
+  size_t m_version = 0;
+  size_t m_removals = 0;
+
+  // the set compares the names in the arena, the offsets are its keys
+  struct NameHash {
+    const std::vector<char>* names;
+    size_t operator()(uint32_t off) const;
+  };
+  struct NameEqual {
+    const std::vector<char>* names;
+    bool operator()(uint32_t a, uint32_t b) const;
+  };
+  std::unordered_set<uint32_t, NameHash, NameEqual> m_interned;
+
+  uint32_t intern(const char* name);
+  void compactNames();
+
+  ViewStore(const ViewStore&);
+  void operator=(const ViewStore&);
+
+public:
+  static const uint32_t NoView = 0xffffffffu;
+
+  ViewStore();
+
+  size_t size() const { return m_start.size(); }
+  bool empty() const { return m_start.empty(); }
+  void clear();
+  void reserve(size_t count);
+
+  // appends a view as a child of the view with the id parent, returns its id. name is copied and must not point
+  // into the store
+  uint32_t add(uint64_t start, uint64_t end, const char* name, uint32_t color, HexViewMode mode,
+               uint32_t parent = NoView);
+  // removes the view at index, the ones after it move up. its children move up to its parent
+  void remove(size_t index);
+  // changes whenever views are added or removed or their range changes, for the things built from the list
+  size_t version() const { return m_version; }
+  // changes when views were removed or cleared, the indices only move then. otherwise views were only appended
+  size_t removals() const { return m_removals; }
+
+  // index of the view with the id, NoView if there's none
+  uint32_t indexOf(uint32_t id) const { return id < m_index_of.size() ? m_index_of[id] : NoView; }
+
+  uint32_t id(size_t index) const { return m_id[index]; }
+  uint32_t parent(size_t index) const { return m_parent[index]; }
+  uint64_t start(size_t index) const { return m_start[index]; }
+  uint64_t end(size_t index) const { return m_end[index]; }
+  const char* name(size_t index) const { return &m_names[m_name[index]]; }
+  uint32_t color(size_t index) const { return m_color[index]; }
+  HexViewMode mode(size_t index) const { return (HexViewMode)m_mode[index]; }
+
+  void setStart(size_t index, uint64_t start) { m_start[index] = start; m_version++; }
+  void setEnd(size_t index, uint64_t end) { m_end[index] = end; m_version++; }
+  void setName(size_t index, const char* name);
+  void setColor(size_t index, uint32_t color) { m_color[index] = color; }
+  void setMode(size_t index, HexViewMode mode) { m_mode[index] = (uint8_t)mode; }
+
+  // bytes used, for the debug info
+  size_t memoryUsage() const;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace io {
+
+class SegmentMap;
+
+/*
+ * abstract random access byte source the hex editor works on.
+ *
+ * reads are span based, a caller should always fetch as many bytes as it needs at once instead of calling read()
+ * per byte. sources which read a file or a process directly have to support reads from several threads at once,
+ * caches and edit layers don't.
+ * */
+class DataSource {
+public:
+  virtual ~DataSource() {}
+
+  virtual size_t size() const = 0;
+
+  // copies up to len bytes starting at off into dst, returns the number of bytes copied
+  virtual size_t read(size_t off, uint8_t* dst, size_t len) = 0;
+
+  // pointer to the whole content if it's directly addressable (e.g. mapped), NULL otherwise
+  virtual const uint8_t* data() const { return nullptr; }
+
+  // addresses of the data if it's not one contiguous block starting at 0, NULL otherwise
+  virtual const SegmentMap* segments() const { return nullptr; }
+
+  // true if the content changes by itself (e.g. process memory), it mustn't be cached for long then
+  virtual bool isVolatile() const { return false; }
+
+  // file descriptor of the underlying file, -1 if there's none
+  virtual int fd() const { return -1; }
+
+  // hint that the given range is about to be read
+  virtual void prefetch(size_t off, size_t len) { (void)off; (void)len; }
+};
+
+}
@@ -0,0 +1,49 @@
+#include "filesource.hpp"
+#include <application/log.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+io::FileSource::~FileSource() { close(); }
+
+bool io::FileSource::open(const std::string& path) {
+  close();
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if(fd < 0) {
+    LOG_ERROR("couldn't open " + path + ": " + strerror(errno))
+    return false;
+  }
+
+  off_t size = lseek(fd, 0, SEEK_END);
+  if(size < 0) {
+    LOG_ERROR("couldn't determine size of " + path + ": " + strerror(errno))
+    ::close(fd);
+    return false;
+  }
+
+  m_fd = fd;
+  m_size = (size_t)size;
+  return true;
+}
+
+void io::FileSource::close() {
+  if(m_fd >= 0)
+    ::close(m_fd);
+  m_fd = -1;
+  m_size = 0;
+}
+
+size_t io::FileSource::read(size_t off, uint8_t* dst, size_t len) {
+  size_t done = 0;
+  while(done < len) {
+    ssize_t r = pread(m_fd, dst + done, len - done, (off_t)(off + done));
+    if(r < 0 && errno == EINTR)
+      continue;
+    if(r <= 0)
+      break;
+    done += (size_t)r;
+  }
+  return done;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include "datasource.hpp"
+
+namespace io {
+
+/*
+ * data source reading a file with pread().
+ *
+ * used for everything that can't be mapped (character devices etc.), it's not cached by itself and should be
+ * wrapped into a PageCache.
+ * */
+class FileSource : public DataSource {
+private:
+  int m_fd = -1;
+  size_t m_size = 0;
+
+  FileSource(const FileSource&);
+  void operator=(const FileSource&);
+
+public:
+  FileSource() {}
+  ~FileSource();
+
+  bool open(const std::string& path);
+  void close();
+
+  size_t size() const override { return m_size; }
+  size_t read(size_t off, uint8_t* dst, size_t len) override;
+  int fd() const override { return m_fd; }
+};
+
+}
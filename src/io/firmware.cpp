@@ -0,0 +1,681 @@
+#include "firmware.hpp"
+#include "mappedfile.hpp"
+#include "save.hpp"
+#include <application/log.hpp>
+#include <algorithm>
+#include <thread>
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+// text files are split into chunks of at least this size for the parser threads
+static const size_t MinChunk = 4 * 1024 * 1024;
+
+// bytes of a text file that were parsed into one run of contiguous addresses
+struct TextRun {
+  uint64_t addr;
+  size_t pos, len;
+  // addr is relative to the extended address in effect at the start of the chunk
+  bool relative;
+};
+
+struct TextChunk {
+  const uint8_t* begin;
+  const uint8_t* end;
+
+  std::vector<uint8_t> bytes;
+  std::vector<TextRun> runs;
+
+  // last extended address record in the chunk
+  bool has_base = false;
+  uint64_t base = 0;
+
+  bool eof = false;
+  bool has_entry = false;
+  uint8_t entry_type = 0;
+  uint64_t entry = 0;
+  bool has_header = false;
+  std::vector<uint8_t> header;
+  size_t record_size = 0;
+  size_t addr_bytes = 0;
+
+  // first malformed line
+  const uint8_t* error = nullptr;
+  bool cancelled = false;
+};
+
+static bool cancelled(const std::atomic<bool>* cancel) {
+  return cancel && cancel->load(std::memory_order_relaxed);
+}
+
+static int nibble(uint8_t c) {
+  if(c >= '0' && c <= '9')
+    return c - '0';
+  if(c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  if(c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  return -1;
+}
+
+// decodes pairs of hex digits, false if there's anything else
+static bool decodeHex(const uint8_t* text, size_t count, uint8_t* out) {
+  for(size_t i = 0; i < count; i++) {
+    int hi = nibble(text[2 * i]), lo = nibble(text[2 * i + 1]);
+    if(hi < 0 || lo < 0)
+      return false;
+    out[i] = (uint8_t)(hi << 4 | lo);
+  }
+  return true;
+}
+
+static void addRun(TextChunk& chunk, uint64_t addr, bool relative, const uint8_t* data, size_t len) {
+  if(!len)
+    return;
+
+  // records usually follow each other, so they end up in one run
+  if(!chunk.runs.empty()) {
+    TextRun& last = chunk.runs.back();
+    if(last.relative == relative && last.addr + last.len == addr) {
+      chunk.bytes.insert(chunk.bytes.end(), data, data + len);
+      last.len += len;
+      return;
+    }
+  }
+  chunk.runs.push_back(TextRun{addr, chunk.bytes.size(), len, relative});
+  chunk.bytes.insert(chunk.bytes.end(), data, data + len);
+}
+
+static bool parseIntelHexLine(TextChunk& chunk, const uint8_t* line, size_t len) {
+  // :LLAAAATT<data>CC
+  uint8_t rec[1 + 2 + 1 + 255 + 1];
+  if(len < 11 || line[0] != ':' || (len - 1) % 2 || (len - 1) / 2 > sizeof(rec))
+    return false;
+  const size_t n = (len - 1) / 2;
+  if(!decodeHex(line + 1, n, rec) || (size_t)rec[0] + 5 != n)
+    return false;
+
+  uint8_t sum = 0;
+  for(size_t i = 0; i < n; i++)
+    sum += rec[i];
+  if(sum)
+    return false;
+
+  const size_t count = rec[0];
+  const uint64_t off = (uint64_t)rec[1] << 8 | rec[2];
+  const uint8_t* data = rec + 4;
+
+  switch(rec[3]) {
+    case 0x00:
+      addRun(chunk, chunk.base + off, !chunk.has_base, data, count);
+      chunk.record_size = std::max(chunk.record_size, count);
+      return true;
+    case 0x01:
+      chunk.eof = true;
+      return true;
+    case 0x02:
+    case 0x04:
+      if(count != 2)
+        return false;
+      // segment base (real mode segment * 16) or upper 16 bits of a linear address
+      chunk.base = ((uint64_t)data[0] << 8 | data[1]) << (rec[3] == 0x02 ? 4 : 16);
+      chunk.has_base = true;
+      return true;
+    case 0x03:
+    case 0x05:
+      if(count != 4)
+        return false;
+      chunk.has_entry = true;
+      chunk.entry_type = rec[3];
+      chunk.entry = (uint64_t)data[0] << 24 | (uint64_t)data[1] << 16 | (uint64_t)data[2] << 8 | data[3];
+      return true;
+    default:
+      return false;
+  }
+}
+
+static bool parseSRecordLine(TextChunk& chunk, const uint8_t* line, size_t len) {
+  // S<type>LL<address><data>CC, the count includes address and checksum
+  static const size_t AddrBytes[10] = {2, 2, 3, 4, 0, 2, 3, 4, 3, 2};
+
+  uint8_t rec[256];
+  if(len < 4 || line[0] != 'S' || line[1] < '0' || line[1] > '9' || len % 2)
+    return false;
+  const int type = line[1] - '0';
+  const size_t n = (len - 2) / 2;
+  if(n > sizeof(rec) || !decodeHex(line + 2, n, rec) || (size_t)rec[0] + 1 != n)
+    return false;
+
+  uint8_t sum = 0;
+  for(size_t i = 0; i < n; i++)
+    sum += rec[i];
+  if(sum != 0xFF)
+    return false;
+
+  const size_t addr_bytes = AddrBytes[type];
+  if(!addr_bytes || rec[0] < addr_bytes + 1)
+    return false;
+
+  uint64_t addr = 0;
+  for(size_t i = 0; i < addr_bytes; i++)
+    addr = addr << 8 | rec[1 + i];
+  const uint8_t* data = rec + 1 + addr_bytes;
+  const size_t count = rec[0] - addr_bytes - 1;
+
+  switch(type) {
+    case 0:
+      chunk.has_header = true;
+      chunk.header.assign(data, data + count);
+      return true;
+    case 1:
+    case 2:
+    case 3:
+      addRun(chunk, addr, false, data, count);
+      chunk.record_size = std::max(chunk.record_size, count);
+      chunk.addr_bytes = std::max(chunk.addr_bytes, addr_bytes);
+      return true;
+    case 5:
+    case 6:
+      // record count, only useful for checking the transfer
+      return true;
+    default:
+      chunk.has_entry = true;
+      chunk.entry_type = (uint8_t)type;
+      chunk.entry = addr;
+      chunk.eof = true;
+      return true;
+  }
+}
+
+static void parseChunk(TextChunk& chunk, io::FirmwareFormat format, const std::atomic<bool>* cancel) {
+  const uint8_t* p = chunk.begin;
+  while(p < chunk.end && !chunk.eof) {
+    if(cancelled(cancel)) {
+      chunk.cancelled = true;
+      return;
+    }
+    const uint8_t* line = p;
+    const uint8_t* eol = (const uint8_t*)memchr(p, '\n', (size_t)(chunk.end - p));
+    if(!eol)
+      eol = chunk.end;
+    p = eol + 1;
+
+    // trailing \r and other whitespace
+    while(eol > line && (eol[-1] == '\r' || eol[-1] == ' ' || eol[-1] == '\t'))
+      eol--;
+    if(eol == line)
+      continue;
+
+    const bool ok = format == io::FirmwareFormat_IntelHex ? parseIntelHexLine(chunk, line, (size_t)(eol - line))
+                                                          : parseSRecordLine(chunk, line, (size_t)(eol - line));
+    if(!ok) {
+      chunk.error = line;
+      return;
+    }
+  }
+}
+
+static size_t lineNumber(const uint8_t* text, const uint8_t* pos) {
+  return (size_t)std::count(text, pos, '\n') + 1;
+}
+
+static void appendHex(std::string& out, const uint8_t* data, size_t len) {
+  static const char Digits[] = "0123456789ABCDEF";
+  for(size_t i = 0; i < len; i++) {
+    out += Digits[data[i] >> 4];
+    out += Digits[data[i] & 0xF];
+  }
+}
+
+static void appendIntelHexRecord(std::string& out, uint8_t type, uint16_t addr, const uint8_t* data, size_t len,
+                                 bool crlf) {
+  uint8_t rec[4 + 255 + 1];
+  rec[0] = (uint8_t)len;
+  rec[1] = (uint8_t)(addr >> 8);
+  rec[2] = (uint8_t)addr;
+  rec[3] = type;
+  if(len)
+    memcpy(rec + 4, data, len);
+
+  uint8_t sum = 0;
+  for(size_t i = 0; i < len + 4; i++)
+    sum += rec[i];
+  rec[len + 4] = (uint8_t)-sum;
+
+  out += ':';
+  appendHex(out, rec, len + 5);
+  out += crlf ? "\r\n" : "\n";
+}
+
+static void appendSRecord(std::string& out, int type, uint64_t addr, size_t addr_bytes, const uint8_t* data,
+                          size_t len, bool crlf) {
+  uint8_t rec[256];
+  const size_t n = 1 + addr_bytes + len + 1;
+  rec[0] = (uint8_t)(n - 1);
+  for(size_t i = 0; i < addr_bytes; i++)
+    rec[1 + i] = (uint8_t)(addr >> (8 * (addr_bytes - 1 - i)));
+  if(len)
+    memcpy(rec + 1 + addr_bytes, data, len);
+
+  uint8_t sum = 0;
+  for(size_t i = 0; i < n - 1; i++)
+    sum += rec[i];
+  rec[n - 1] = (uint8_t)~sum;
+
+  out += 'S';
+  out += (char)('0' + type);
+  appendHex(out, rec, n);
+  out += crlf ? "\r\n" : "\n";
+}
+
+static bool writeAll(int fd, const uint8_t* buf, size_t len, uint64_t off) {
+  while(len) {
+    ssize_t r = pwrite(fd, buf, len, (off_t)off);
+    if(r < 0 && errno == EINTR)
+      continue;
+    if(r <= 0)
+      return false;
+    buf += r;
+    len -= (size_t)r;
+    off += (size_t)r;
+  }
+  return true;
+}
+
+static uint16_t fromElf(uint16_t v, bool swap) { return swap ? __builtin_bswap16(v) : v; }
+static uint32_t fromElf(uint32_t v, bool swap) { return swap ? __builtin_bswap32(v) : v; }
+static uint64_t fromElf(uint64_t v, bool swap) { return swap ? __builtin_bswap64(v) : v; }
+
+struct ElfSegment {
+  uint64_t paddr, vaddr;
+  uint64_t offset, filesz;
+  uint32_t flags;
+};
+
+// PT_LOAD entries of the program header table
+template<typename Ehdr, typename Phdr>
+static bool readLoadSegments(const uint8_t* file, size_t len, bool swap, std::vector<ElfSegment>& segments) {
+  Ehdr eh;
+  if(len < sizeof(eh))
+    return false;
+  memcpy(&eh, file, sizeof(eh));
+
+  const uint64_t phoff = fromElf(eh.e_phoff, swap);
+  const size_t phentsize = fromElf(eh.e_phentsize, swap);
+  const size_t phnum = fromElf(eh.e_phnum, swap);
+  if(!phnum)
+    return true;
+  if(phentsize < sizeof(Phdr) || phoff > len || phnum * phentsize > len - phoff)
+    return false;
+
+  for(size_t i = 0; i < phnum; i++) {
+    Phdr ph;
+    memcpy(&ph, file + phoff + i * phentsize, sizeof(ph));
+    if(fromElf(ph.p_type, swap) != PT_LOAD)
+      continue;
+    segments.push_back(ElfSegment{fromElf(ph.p_paddr, swap), fromElf(ph.p_vaddr, swap), fromElf(ph.p_offset, swap),
+                                  fromElf(ph.p_filesz, swap), fromElf(ph.p_flags, swap)});
+  }
+  return true;
+}
+
+io::FirmwareFormat io::detectFirmwareFormat(const std::string& path) {
+  std::string ext;
+  const size_t dot = path.find_last_of("./");
+  if(dot != std::string::npos && path[dot] == '.')
+    ext = path.substr(dot + 1);
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+  // the content has to match as well, a .hex file might just as well be a binary dump
+  uint8_t head[SELFMAG] = {};
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if(fd < 0)
+    return FirmwareFormat_None;
+  const ssize_t r = ::read(fd, head, sizeof(head));
+  ::close(fd);
+  if(r != (ssize_t)sizeof(head))
+    return FirmwareFormat_None;
+
+  if((ext == "hex" || ext == "ihx" || ext == "ihex" || ext == "h86") && head[0] == ':' && nibble(head[1]) >= 0)
+    return FirmwareFormat_IntelHex;
+  if((ext == "s19" || ext == "s28" || ext == "s37" || ext == "srec" || ext == "mot" || ext == "sx") &&
+     head[0] == 'S' && head[1] >= '0' && head[1] <= '9')
+    return FirmwareFormat_SRecord;
+  if((ext == "elf" || ext == "axf") && memcmp(head, ELFMAG, SELFMAG) == 0)
+    return FirmwareFormat_Elf;
+  return FirmwareFormat_None;
+}
+
+bool io::FirmwareImage::load(const std::string& path, FirmwareFormat format, const std::atomic<bool>* cancel) {
+  m_format = format;
+  m_data.clear();
+  m_segments.clear();
+  m_file_offsets.clear();
+
+  MappedFile file;
+  if(!file.open(path))
+    return false;
+
+  if(format == FirmwareFormat_Elf)
+    return loadElf(file.data(), file.size(), path, cancel);
+  return loadText(file.data(), file.size(), path, cancel);
+}
+
+bool io::FirmwareImage::loadText(const uint8_t* text, size_t len, const std::string& path,
+                                 const std::atomic<bool>* cancel) {
+  const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+  const size_t count = std::max((size_t)1, std::min(threads, len / MinChunk));
+
+  // split into chunks of about the same size, each starting at a line
+  std::vector<TextChunk> chunks(count);
+  const uint8_t* end = text + len;
+  const uint8_t* p = text;
+  for(size_t i = 0; i < count; i++) {
+    chunks[i].begin = p;
+    if(i + 1 < count) {
+      p = std::max(p, text + len / count * (i + 1));
+      const uint8_t* eol = (const uint8_t*)memchr(p, '\n', (size_t)(end - p));
+      p = eol ? eol + 1 : end;
+    } else {
+      p = end;
+    }
+    chunks[i].end = p;
+  }
+
+  std::vector<std::thread> workers;
+  for(size_t i = 1; i < count; i++)
+    workers.emplace_back(parseChunk, std::ref(chunks[i]), m_format, cancel);
+  parseChunk(chunks[0], m_format, cancel);
+  for(auto& worker : workers)
+    worker.join();
+
+  // resolve the addresses relative to the extended address records of the chunks before
+  struct Placed {
+    uint64_t addr;
+    const uint8_t* data;
+    size_t len;
+  };
+  std::vector<Placed> placed;
+  uint64_t base = 0;
+  size_t total = 0;
+  m_record_size = 0;
+  m_addr_bytes = 2;
+  m_header.clear();
+  m_has_entry = false;
+
+  for(auto& chunk : chunks) {
+    if(chunk.cancelled)
+      return false;
+    if(chunk.error) {
+      LOG_ERROR(path + ":" + std::to_string(lineNumber(text, chunk.error)) + ": malformed record")
+      return false;
+    }
+
+    for(auto& run : chunk.runs) {
+      placed.push_back(Placed{run.relative ? base + run.addr : run.addr, chunk.bytes.data() + run.pos, run.len});
+      total += run.len;
+    }
+    if(chunk.has_base)
+      base = chunk.base;
+
+    m_record_size = std::max(m_record_size, chunk.record_size);
+    m_addr_bytes = std::max(m_addr_bytes, chunk.addr_bytes);
+    if(chunk.has_header && m_header.empty())
+      m_header = chunk.header;
+    if(chunk.has_entry) {
+      m_has_entry = true;
+      m_entry_type = chunk.entry_type;
+      m_entry = chunk.entry;
+    }
+
+    // anything after the end of file record is ignored
+    if(chunk.eof)
+      break;
+  }
+  if(!m_record_size)
+    m_record_size = 16;
+
+  const uint8_t* eol = len ? (const uint8_t*)memchr(text, '\n', len) : nullptr;
+  m_crlf = eol && eol > text && eol[-1] == '\r';
+
+  // records can come in any order, the segments are laid out by address
+  std::stable_sort(placed.begin(), placed.end(), [](const Placed& a, const Placed& b) { return a.addr < b.addr; });
+
+  std::vector<std::pair<uint64_t, size_t>> segments;
+  size_t segment_off = 0;
+  bool overlap = false;
+  m_data.reserve(total);
+  for(auto& run : placed) {
+    if(cancelled(cancel))
+      return false;
+    if(!segments.empty() && run.addr <= segments.back().first + segments.back().second) {
+      auto& segment = segments.back();
+      const uint64_t segment_end = segment.first + segment.second;
+      const uint64_t run_end = run.addr + run.len;
+      if(run.addr < segment_end)
+        overlap = true;
+      if(run_end > segment_end) {
+        m_data.resize(m_data.size() + (size_t)(run_end - segment_end));
+        segment.second = (size_t)(run_end - segment.first);
+      }
+      memcpy(m_data.data() + segment_off + (run.addr - segment.first), run.data, run.len);
+    } else {
+      segment_off = m_data.size();
+      segments.push_back(std::make_pair(run.addr, run.len));
+      m_data.insert(m_data.end(), run.data, run.data + run.len);
+    }
+  }
+  if(overlap)
+    LOG_WARN(path + " has records with overlapping addresses")
+
+  for(size_t i = 0; i < segments.size(); i++)
+    m_segments.add(segments[i].first, segments[i].second, "segment " + std::to_string(i));
+
+  return true;
+}
+
+bool io::FirmwareImage::loadElf(const uint8_t* file, size_t len, const std::string& path,
+                                const std::atomic<bool>* cancel) {
+  if(len < EI_NIDENT || memcmp(file, ELFMAG, SELFMAG) != 0) {
+    LOG_ERROR(path + " isn't an ELF file")
+    return false;
+  }
+
+  const bool big_endian = file[EI_DATA] == ELFDATA2MSB;
+  const bool swap = big_endian != (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__);
+
+  std::vector<ElfSegment> segments;
+  bool ok = false;
+  if(file[EI_CLASS] == ELFCLASS64)
+    ok = readLoadSegments<Elf64_Ehdr, Elf64_Phdr>(file, len, swap, segments);
+  else if(file[EI_CLASS] == ELFCLASS32)
+    ok = readLoadSegments<Elf32_Ehdr, Elf32_Phdr>(file, len, swap, segments);
+  if(!ok) {
+    LOG_ERROR(path + " has a broken program header table")
+    return false;
+  }
+
+  // the load addresses are what ends up in flash, executables for an os often leave them 0 though
+  bool use_paddr = false;
+  for(auto& segment : segments)
+    use_paddr |= segment.paddr != 0;
+
+  for(auto& segment : segments) {
+    if(cancelled(cancel))
+      return false;
+    // the rest up to p_memsz is zero initialized and not in the file
+    if(!segment.filesz)
+      continue;
+    if(segment.offset > len || segment.filesz > len - segment.offset) {
+      LOG_ERROR(path + " is truncated, a segment reaches past the end of the file")
+      return false;
+    }
+
+    std::string name = "LOAD ";
+    name += (segment.flags & PF_R) ? 'r' : '-';
+    name += (segment.flags & PF_W) ? 'w' : '-';
+    name += (segment.flags & PF_X) ? 'x' : '-';
+    m_segments.add(use_paddr ? segment.paddr : segment.vaddr, (size_t)segment.filesz, name);
+    m_file_offsets.push_back(segment.offset);
+    m_data.insert(m_data.end(), file + segment.offset, file + segment.offset + segment.filesz);
+  }
+
+  return true;
+}
+
+size_t io::FirmwareImage::read(size_t off, uint8_t* dst, size_t len) {
+  if(off >= m_data.size())
+    return 0;
+  len = std::min(len, m_data.size() - off);
+  memcpy(dst, m_data.data() + off, len);
+  return len;
+}
+
+bool io::FirmwareImage::save(PieceTable& edit, const std::string& path) const {
+  if(edit.size() != m_data.size()) {
+    LOG_ERROR("can't save " + path + " with inserted or deleted bytes, the segments would move")
+    return false;
+  }
+
+  std::string out;
+  switch(m_format) {
+    case FirmwareFormat_IntelHex:
+      if(!writeIntelHex(edit, out))
+        return false;
+      break;
+    case FirmwareFormat_SRecord:
+      if(!writeSRecord(edit, out))
+        return false;
+      break;
+    case FirmwareFormat_Elf:
+      return patchElf(edit, path);
+    default:
+      return false;
+  }
+  return replaceFile(path, out);
+}
+
+bool io::FirmwareImage::writeIntelHex(PieceTable& edit, std::string& out) const {
+  const size_t record_size = std::min(m_record_size, (size_t)255);
+  out.reserve(m_data.size() * 2 + (m_data.size() / record_size + 1) * 13);
+
+  std::vector<uint8_t> block(0x10000);
+  uint64_t upper = 0;
+  for(auto& segment : m_segments.segments()) {
+    if(segment.addr + segment.size - 1 > 0xFFFFFFFF) {
+      LOG_ERROR("intel hex can't store addresses above 4GB")
+      return false;
+    }
+
+    for(size_t done = 0; done < segment.size; ) {
+      // a block never crosses a 64K boundary, so it needs one extended linear address record at most
+      const uint64_t addr = segment.addr + done;
+      const size_t n = (size_t)std::min<uint64_t>(segment.size - done, 0x10000 - (addr & 0xFFFF));
+      if(addr >> 16 != upper) {
+        upper = addr >> 16;
+        const uint8_t ext[2] = {(uint8_t)(upper >> 8), (uint8_t)upper};
+        appendIntelHexRecord(out, 0x04, 0, ext, 2, m_crlf);
+      }
+
+      if(edit.read(segment.offset + done, block.data(), n) != n)
+        return false;
+      for(size_t i = 0; i < n; i += record_size)
+        appendIntelHexRecord(out, 0x00, (uint16_t)(addr + i), block.data() + i, std::min(record_size, n - i), m_crlf);
+      done += n;
+    }
+  }
+
+  if(m_has_entry) {
+    const uint8_t entry[4] = {(uint8_t)(m_entry >> 24), (uint8_t)(m_entry >> 16), (uint8_t)(m_entry >> 8),
+                              (uint8_t)m_entry};
+    appendIntelHexRecord(out, m_entry_type, 0, entry, 4, m_crlf);
+  }
+  appendIntelHexRecord(out, 0x01, 0, nullptr, 0, m_crlf);
+  return true;
+}
+
+bool io::FirmwareImage::writeSRecord(PieceTable& edit, std::string& out) const {
+  // S1/S2/S3 as in the file, unless an address doesn't fit anymore
+  const uint64_t max_addr = m_segments.maxAddress();
+  size_t addr_bytes = m_addr_bytes;
+  while(addr_bytes < 4 && max_addr >> (8 * addr_bytes))
+    addr_bytes++;
+  if(max_addr >> 32) {
+    LOG_ERROR("s-records can't store addresses above 4GB")
+    return false;
+  }
+
+  const size_t record_size = std::min(m_record_size, 255 - addr_bytes - 1);
+  out.reserve(m_data.size() * 2 + (m_data.size() / record_size + 1) * 16);
+
+  appendSRecord(out, 0, 0, 2, m_header.data(), m_header.size(), m_crlf);
+
+  std::vector<uint8_t> block(0x10000);
+  size_t records = 0;
+  for(auto& segment : m_segments.segments()) {
+    for(size_t done = 0; done < segment.size; ) {
+      const size_t n = std::min(segment.size - done, block.size());
+      if(edit.read(segment.offset + done, block.data(), n) != n)
+        return false;
+      for(size_t i = 0; i < n; i += record_size, records++)
+        appendSRecord(out, (int)addr_bytes - 1, segment.addr + done + i, addr_bytes, block.data() + i,
+                      std::min(record_size, n - i), m_crlf);
+      done += n;
+    }
+  }
+
+  if(records <= 0xFFFF)
+    appendSRecord(out, 5, records, 2, nullptr, 0, m_crlf);
+  else if(records <= 0xFFFFFF)
+    appendSRecord(out, 6, records, 3, nullptr, 0, m_crlf);
+
+  // S9/S8/S7 for S1/S2/S3
+  appendSRecord(out, 11 - (int)addr_bytes, m_has_entry ? m_entry : 0, addr_bytes, nullptr, 0, m_crlf);
+  return true;
+}
+
+bool io::FirmwareImage::patchElf(PieceTable& edit, const std::string& path) const {
+  // dirty extents of the data, the same way a binary is saved in place
+  std::vector<std::pair<size_t, size_t>> extents;
+  edit.forEachPiece([&](size_t pos, const Piece& piece) {
+    if(piece.kind == PieceKind_Original && piece.off == pos)
+      return;
+    if(!extents.empty() && extents.back().first + extents.back().second == pos)
+      extents.back().second += piece.len;
+    else
+      extents.push_back(std::make_pair(pos, piece.len));
+  });
+
+  int fd = ::open(path.c_str(), O_WRONLY);
+  if(fd < 0) {
+    LOG_ERROR("couldn't open " + path + " for writing: " + strerror(errno))
+    return false;
+  }
+
+  std::vector<uint8_t> buf(0x10000);
+  bool ok = true;
+  for(auto& extent : extents) {
+    size_t pos = extent.first, len = extent.second;
+    while(ok && len) {
+      // extents can span segments, which aren't next to each other in the file
+      const size_t index = m_segments.segmentAt(pos);
+      const Segment& segment = m_segments.segments()[index];
+      const size_t n = std::min(std::min(len, segment.offset + segment.size - pos), buf.size());
+      ok = edit.read(pos, buf.data(), n) == n &&
+           writeAll(fd, buf.data(), n, m_file_offsets[index] + (pos - segment.offset));
+      pos += n;
+      len -= n;
+    }
+  }
+  if(!ok)
+    LOG_ERROR("couldn't write " + path + ": " + strerror(errno))
+
+  if(ok && fsync(fd) != 0) {
+    LOG_ERROR("couldn't sync " + path + ": " + strerror(errno))
+    ok = false;
+  }
+  ::close(fd);
+  return ok;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include "datasource.hpp"
+#include "segmentmap.hpp"
+#include "piecetable.hpp"
+
+namespace io {
+
+enum FirmwareFormat { FirmwareFormat_None, FirmwareFormat_IntelHex, FirmwareFormat_SRecord, FirmwareFormat_Elf };
+
+// guesses the format from the extension and the first bytes, FirmwareFormat_None for plain binaries
+FirmwareFormat detectFirmwareFormat(const std::string& path);
+
+/*
+ * firmware image loaded from an Intel HEX, Motorola S-record or ELF file.
+ *
+ * only the bytes which are actually in the file are kept, one segment per contiguous address range (per PT_LOAD
+ * segment for ELF). text files are parsed in parallel chunks split at line starts, the extended address records
+ * of Intel HEX are resolved sequentially afterwards, so a chunk doesn't need to know the records before it.
+ *
+ * save() writes the edited bytes back in the original format: text files are generated again (same record size
+ * and line endings), ELF files are patched in place at the file offsets of the segments. bytes can't be inserted
+ * or deleted, the segments would move.
+ * */
+class FirmwareImage : public DataSource {
+private:
+  FirmwareFormat m_format = FirmwareFormat_None;
+  std::vector<uint8_t> m_data;
+  SegmentMap m_segments;
+  // position of every segment in the ELF file
+  std::vector<uint64_t> m_file_offsets;
+
+  // how the text file was written
+  size_t m_record_size = 16;
+  size_t m_addr_bytes = 2;
+  bool m_crlf = false;
+  std::vector<uint8_t> m_header;
+  bool m_has_entry = false;
+  uint8_t m_entry_type = 0;
+  uint64_t m_entry = 0;
+
+  bool loadText(const uint8_t* text, size_t len, const std::string& path, const std::atomic<bool>* cancel);
+  bool loadElf(const uint8_t* file, size_t len, const std::string& path, const std::atomic<bool>* cancel);
+
+  bool writeIntelHex(PieceTable& edit, std::string& out) const;
+  bool writeSRecord(PieceTable& edit, std::string& out) const;
+  bool patchElf(PieceTable& edit, const std::string& path) const;
+
+  FirmwareImage(const FirmwareImage&);
+  void operator=(const FirmwareImage&);
+
+public:
+  FirmwareImage() {}
+
+  // parsing stops (and fails) as soon as cancel is set
+  bool load(const std::string& path, FirmwareFormat format, const std::atomic<bool>* cancel = nullptr);
+  FirmwareFormat format() const { return m_format; }
+
+  const uint8_t* data() const override { return m_data.empty() ? nullptr : m_data.data(); }
+  size_t size() const override { return m_data.size(); }
+  size_t read(size_t off, uint8_t* dst, size_t len) override;
+  const SegmentMap* segments() const override { return &m_segments; }
+
+  // writes the edited data to path (the file it was loaded from)
+  bool save(PieceTable& edit, const std::string& path) const;
+};
+
+}
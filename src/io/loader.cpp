@@ -0,0 +1,132 @@
+#include "loader.hpp"
+#include "mappedfile.hpp"
+#include "filesource.hpp"
+#include "firmware.hpp"
+#include <application/log.hpp>
+#include <algorithm>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+const size_t io::Loader::FirstScreen;
+
+void io::Loader::load(const std::string& path, bool read_ahead, bool parse_firmware) {
+  cancel();
+
+  m_path = path;
+  m_read_ahead = read_ahead;
+  m_parse_firmware = parse_firmware;
+  m_cancel = false;
+  m_done = 0;
+  m_total = 0;
+  m_state = LoaderState_Opening;
+
+  m_thread = std::thread(&Loader::run, this);
+}
+
+void io::Loader::cancel() {
+  m_cancel = true;
+  if(m_thread.joinable())
+    m_thread.join();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_result.reset();
+  if(isRunning())
+    m_state = LoaderState_Idle;
+}
+
+std::unique_ptr<io::DataSource> io::Loader::take() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return std::move(m_result);
+}
+
+float io::Loader::progress() const {
+  const size_t total = m_total;
+  if(!total)
+    return state() == LoaderState_Done ? 1.0f : 0.0f;
+  return (float)((double)m_done / (double)total);
+}
+
+void io::Loader::run() {
+  if(m_parse_firmware && openFirmware())
+    return;
+
+  std::unique_ptr<DataSource> source;
+
+  auto mapped = std::unique_ptr<MappedFile>(new MappedFile);
+  if(mapped->open(m_path)) {
+    // browsing jumps around, so don't let the kernel read ahead too much
+    mapped->advise(AccessHint_Random);
+    source = std::move(mapped);
+  } else {
+    // fall back to reading through the page cache
+    auto file = std::unique_ptr<FileSource>(new FileSource);
+    if(!file->open(m_path)) {
+      m_state = LoaderState_Failed;
+      return;
+    }
+    source = std::move(file);
+  }
+
+  // wait for the first screenful, so it can be rendered right away
+  std::vector<uint8_t> first(std::min(FirstScreen, source->size()));
+  source->read(0, first.data(), first.size());
+
+  if(m_cancel)
+    return;
+
+  const int fd = source->fd();
+  const size_t size = source->size();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_result = std::move(source);
+  }
+
+  if(m_read_ahead && fd >= 0) {
+    m_state = LoaderState_ReadingAhead;
+    readAhead(fd, size);
+  }
+
+  m_state = LoaderState_Done;
+}
+
+bool io::Loader::openFirmware() {
+  const FirmwareFormat format = detectFirmwareFormat(m_path);
+  if(format == FirmwareFormat_None)
+    return false;
+
+  auto image = std::unique_ptr<FirmwareImage>(new FirmwareImage);
+  if(!image->load(m_path, format, &m_cancel)) {
+    if(!m_cancel)
+      m_state = LoaderState_Failed;
+    return true;
+  }
+
+  if(m_cancel)
+    return true;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_result = std::move(image);
+  }
+  m_state = LoaderState_Done;
+  return true;
+}
+
+void io::Loader::readAhead(int fd, size_t size) {
+  // reads into a scratch buffer, the data ends up in the page cache of the os and not in our memory
+  static const size_t Chunk = 4 * 1024 * 1024;
+  std::vector<uint8_t> scratch(Chunk);
+
+  m_total = size;
+  for(size_t off = FirstScreen; off < size && !m_cancel; ) {
+    ssize_t r = pread(fd, scratch.data(), std::min(Chunk, size - off), (off_t)off);
+    if(r < 0 && errno == EINTR)
+      continue;
+    if(r <= 0)
+      break;
+    off += (size_t)r;
+    m_done = off;
+  }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include "datasource.hpp"
+
+namespace io {
+
+enum LoaderState { LoaderState_Idle, LoaderState_Opening, LoaderState_ReadingAhead, LoaderState_Done,
+                   LoaderState_Failed };
+
+/*
+ * opens files on a worker thread.
+ *
+ * the worker opens the file and reads the first screenful, then the source is handed over (take()) and can be
+ * displayed while the worker keeps reading the rest of the file ahead into the OS page cache. reading ahead only
+ * goes through the file descriptor, the handed over source isn't touched by the worker.
+ *
+ * Intel HEX, S-record and ELF files are parsed completely on the worker (see FirmwareImage) before they're handed
+ * over, there's nothing to read ahead for them.
+ *
+ * cancel() stops the worker and waits for it, it has to be called before the handed over source is destroyed.
+ * */
+class Loader {
+private:
+  std::thread m_thread;
+  std::mutex m_mutex;
+
+  std::atomic<bool> m_cancel{false};
+  std::atomic<int> m_state{LoaderState_Idle};
+  std::atomic<size_t> m_done{0};
+  std::atomic<size_t> m_total{0};
+
+  std::string m_path;
+  bool m_read_ahead = true;
+  bool m_parse_firmware = true;
+  // set once the file is open, until it's taken
+  std::unique_ptr<DataSource> m_result;
+
+  void run();
+  bool openFirmware();
+  void readAhead(int fd, size_t size);
+
+  Loader(const Loader&);
+  void operator=(const Loader&);
+
+public:
+  // bytes read before the source is handed over
+  static const size_t FirstScreen = 64 * 1024;
+
+  Loader() {}
+  ~Loader() { cancel(); }
+
+  // starts loading path, cancels a running load first. firmware files are opened as plain binaries if
+  // parse_firmware is false
+  void load(const std::string& path, bool read_ahead = true, bool parse_firmware = true);
+  // stops the worker and waits for it
+  void cancel();
+
+  // returns the opened source once, NULL if it's not open yet (or was taken already)
+  std::unique_ptr<DataSource> take();
+
+  LoaderState state() const { return (LoaderState)m_state.load(); }
+  bool isRunning() const { return state() == LoaderState_Opening || state() == LoaderState_ReadingAhead; }
+  const std::string& path() const { return m_path; }
+  // 0..1 of the read ahead
+  float progress() const;
+};
+
+}
@@ -0,0 +1,104 @@
+#include "mappedfile.hpp"
+#include <application/log.hpp>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <algorithm>
+
+static size_t pageSize() {
+  static size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  return page_size;
+}
+
+io::MappedFile::~MappedFile() { close(); }
+
+bool io::MappedFile::open(const std::string& path) {
+  close();
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if(fd < 0) {
+    LOG_ERROR("couldn't open " + path + ": " + strerror(errno))
+    return false;
+  }
+
+  struct stat st;
+  if(fstat(fd, &st) != 0 || !(S_ISREG(st.st_mode) || S_ISBLK(st.st_mode))) {
+    LOG_WARN("can't map " + path + ", it's neither a regular file nor a block device")
+    ::close(fd);
+    return false;
+  }
+
+  // block devices report a size of 0 in st_size
+  off_t size = lseek(fd, 0, SEEK_END);
+  if(size < 0) {
+    LOG_ERROR("couldn't determine size of " + path + ": " + strerror(errno))
+    ::close(fd);
+    return false;
+  }
+
+  uint8_t* data = nullptr;
+  if(size > 0) {
+    void* ptr = mmap(NULL, (size_t)size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(ptr == MAP_FAILED) {
+      LOG_ERROR("couldn't map " + path + ": " + strerror(errno))
+      ::close(fd);
+      return false;
+    }
+    data = (uint8_t*)ptr;
+  }
+
+  m_fd = fd;
+  m_data = data;
+  m_size = (size_t)size;
+  m_path = path;
+
+  return true;
+}
+
+void io::MappedFile::close() {
+  if(m_data)
+    munmap(m_data, m_size);
+  if(m_fd >= 0)
+    ::close(m_fd);
+
+  m_fd = -1;
+  m_data = nullptr;
+  m_size = 0;
+  m_path.clear();
+}
+
+size_t io::MappedFile::read(size_t off, uint8_t* dst, size_t len) {
+  if(off >= m_size)
+    return 0;
+
+  len = std::min(len, m_size - off);
+  memcpy(dst, m_data + off, len);
+  return len;
+}
+
+void io::MappedFile::advise(AccessHint hint) {
+  if(!m_data)
+    return;
+
+  int advice = MADV_NORMAL;
+  switch(hint) {
+    case AccessHint_Normal: advice = MADV_NORMAL; break;
+    case AccessHint_Random: advice = MADV_RANDOM; break;
+    case AccessHint_Sequential: advice = MADV_SEQUENTIAL; break;
+  }
+  madvise(m_data, m_size, advice);
+}
+
+void io::MappedFile::willNeed(size_t off, size_t len) {
+  if(!m_data || off >= m_size)
+    return;
+
+  len = std::min(len, m_size - off);
+
+  // madvise wants a page aligned start address
+  size_t aligned = off & ~(pageSize() - 1);
+  madvise(m_data + aligned, len + (off - aligned), MADV_WILLNEED);
+}
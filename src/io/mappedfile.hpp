@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include "datasource.hpp"
+
+namespace io {
+
+enum AccessHint { AccessHint_Normal, AccessHint_Random, AccessHint_Sequential };
+
+/*
+ * read-only memory mapping of a file or block device.
+ *
+ * opening only maps the file, no data is read. the kernel faults pages in when they're accessed, so opening a
+ * multi gigabyte image is O(1) and several of them can be open at once without the memory being committed.
+ *
+ * the mapping is private and never written to, writing the file has to go through the file descriptor.
+ * */
+class MappedFile : public DataSource {
+private:
+  int m_fd = -1;
+  uint8_t* m_data = nullptr;
+  size_t m_size = 0;
+  std::string m_path;
+
+  MappedFile(const MappedFile&);
+  void operator=(const MappedFile&);
+
+public:
+  MappedFile() {}
+  ~MappedFile();
+
+  // maps the file at path, a previously opened file is closed first
+  bool open(const std::string& path);
+  void close();
+
+  bool isOpen() const { return m_fd >= 0; }
+
+  // start of the mapping, NULL for closed or empty files
+  const uint8_t* data() const override { return m_data; }
+  size_t size() const override { return m_size; }
+  size_t read(size_t off, uint8_t* dst, size_t len) override;
+  void prefetch(size_t off, size_t len) override { willNeed(off, len); }
+  int fd() const override { return m_fd; }
+  const std::string& path() const { return m_path; }
+
+  // tells the kernel how the whole mapping is going to be accessed (readahead behaviour)
+  void advise(AccessHint hint);
+
+  // asks the kernel to fault in the given range in the background
+  void willNeed(size_t off, size_t len);
+};
+
+}
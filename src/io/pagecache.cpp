@@ -0,0 +1,101 @@
+#include "pagecache.hpp"
+#include <algorithm>
+#include <string.h>
+
+io::PageCache::PageCache(size_t page_size, size_t budget) : m_page_size(page_size), m_budget(budget) {}
+
+void io::PageCache::setSource(DataSource* source) {
+  invalidate();
+  m_source = source;
+  m_hits = 0;
+  m_misses = 0;
+}
+
+void io::PageCache::setBudget(size_t budget) {
+  m_budget = budget;
+  shrink(std::max((size_t)1, m_budget / m_page_size));
+}
+
+void io::PageCache::invalidate() {
+  m_pages.clear();
+  m_lookup.clear();
+}
+
+void io::PageCache::invalidate(size_t off, size_t len) {
+  if(!len)
+    return;
+  for(size_t index = off / m_page_size; index <= (off + len - 1) / m_page_size; index++) {
+    auto it = m_lookup.find(index);
+    if(it != m_lookup.end()) {
+      m_pages.erase(it->second);
+      m_lookup.erase(it);
+    }
+  }
+}
+
+void io::PageCache::shrink(size_t max_pages) {
+  while(m_pages.size() > max_pages) {
+    m_lookup.erase(m_pages.back().index);
+    m_pages.pop_back();
+  }
+}
+
+const io::PageCache::Page& io::PageCache::page(size_t index) {
+  auto it = m_lookup.find(index);
+  if(it != m_lookup.end()) {
+    m_hits++;
+    m_pages.splice(m_pages.begin(), m_pages, it->second);
+    return m_pages.front();
+  }
+
+  m_misses++;
+
+  // recycle the least recently used page if the budget is used up
+  size_t max_pages = std::max((size_t)1, m_budget / m_page_size);
+  shrink(max_pages);
+  if(m_pages.size() == max_pages) {
+    m_lookup.erase(m_pages.back().index);
+    m_pages.splice(m_pages.begin(), m_pages, std::prev(m_pages.end()));
+  } else {
+    m_pages.emplace_front();
+    m_pages.front().data.resize(m_page_size);
+  }
+
+  Page& p = m_pages.front();
+  p.index = index;
+  p.len = m_source->read(index * m_page_size, p.data.data(), m_page_size);
+  m_lookup[index] = m_pages.begin();
+
+  return p;
+}
+
+size_t io::PageCache::read(size_t off, uint8_t* dst, size_t len) {
+  if(!m_source || off >= size())
+    return 0;
+
+  len = std::min(len, size() - off);
+
+  if(const uint8_t* direct = m_source->data()) {
+    memcpy(dst, direct + off, len);
+    return len;
+  }
+
+  size_t done = 0;
+  while(done < len) {
+    size_t pos = off + done;
+    const Page& p = page(pos / m_page_size);
+    size_t in_page = pos % m_page_size;
+    if(in_page >= p.len)
+      break;
+
+    size_t n = std::min(len - done, p.len - in_page);
+    memcpy(dst + done, p.data.data() + in_page, n);
+    done += n;
+  }
+  return done;
+}
+
+void io::PageCache::prefetch(size_t off, size_t len) {
+  if(m_source)
+    m_source->prefetch(off, len);
+}
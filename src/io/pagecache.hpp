@@ -0,0 +1,70 @@
+#pragma once
+
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include "datasource.hpp"
+
+namespace io {
+
+/*
+ * bounded LRU cache of fixed size pages in front of a data source.
+ *
+ * the cache never holds more than the memory budget (rounded up to one page), so sources bigger than the memory can
+ * be displayed. sources which are directly addressable (mapped files) are passed through, the kernel is caching
+ * those already.
+ *
+ * the source isn't owned by the cache.
+ * */
+class PageCache : public DataSource {
+private:
+  struct Page {
+    size_t index;
+    size_t len;
+    std::vector<uint8_t> data;
+  };
+
+  DataSource* m_source = nullptr;
+  size_t m_page_size;
+  size_t m_budget;
+
+  // most recently used page first
+  std::list<Page> m_pages;
+  std::unordered_map<size_t, std::list<Page>::iterator> m_lookup;
+
+  size_t m_hits = 0;
+  size_t m_misses = 0;
+
+  const Page& page(size_t index);
+  void shrink(size_t max_pages);
+
+public:
+  explicit PageCache(size_t page_size = 64 * 1024, size_t budget = 64 * 1024 * 1024);
+
+  void setSource(DataSource* source);
+  DataSource* source() const { return m_source; }
+
+  // memory budget in bytes, evicts pages if the cache is above the new budget
+  void setBudget(size_t budget);
+  size_t budget() const { return m_budget; }
+  size_t pageSize() const { return m_page_size; }
+
+  // drops all cached pages
+  void invalidate();
+  // drops the cached pages overlapping the given range
+  void invalidate(size_t off, size_t len);
+
+  size_t cachedBytes() const { return m_pages.size() * m_page_size; }
+  size_t hits() const { return m_hits; }
+  size_t misses() const { return m_misses; }
+
+  size_t size() const override { return m_source ? m_source->size() : 0; }
+  size_t read(size_t off, uint8_t* dst, size_t len) override;
+  const uint8_t* data() const override { return m_source ? m_source->data() : nullptr; }
+  int fd() const override { return m_source ? m_source->fd() : -1; }
+  const SegmentMap* segments() const override { return m_source ? m_source->segments() : nullptr; }
+  bool isVolatile() const override { return m_source && m_source->isVolatile(); }
+  void prefetch(size_t off, size_t len) override;
+};
+
+}
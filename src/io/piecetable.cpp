@@ -0,0 +1,326 @@
+#include "piecetable.hpp"
+#include <algorithm>
+#include <string.h>
+
+io::PieceTable::PieceTable() {
+  m_nodes.resize(1);
+  m_nodes[Null].total = 0;
+}
+
+io::PieceTable::NodeRef io::PieceTable::createNode(const Piece& piece) {
+  // xorshift, only used to keep the treap balanced
+  m_seed ^= m_seed << 13;
+  m_seed ^= m_seed >> 17;
+  m_seed ^= m_seed << 5;
+
+  NodeRef n;
+  if(!m_free.empty()) {
+    n = m_free.back();
+    m_free.pop_back();
+  } else {
+    n = (NodeRef)m_nodes.size();
+    m_nodes.emplace_back();
+  }
+
+  Node& node = m_nodes[n];
+  node.piece = piece;
+  node.left = Null;
+  node.right = Null;
+  node.priority = m_seed;
+  node.total = piece.len;
+  return n;
+}
+
+void io::PieceTable::freeTree(NodeRef n) {
+  if(n == Null)
+    return;
+  freeTree(m_nodes[n].left);
+  freeTree(m_nodes[n].right);
+  m_free.push_back(n);
+}
+
+void io::PieceTable::update(NodeRef n) {
+  Node& node = m_nodes[n];
+  node.total = total(node.left) + node.piece.len + total(node.right);
+}
+
+void io::PieceTable::split(NodeRef n, size_t pos, NodeRef& left, NodeRef& right) {
+  if(n == Null) {
+    left = right = Null;
+    return;
+  }
+
+  const size_t left_len = total(m_nodes[n].left);
+  const size_t piece_len = m_nodes[n].piece.len;
+
+  if(pos <= left_len) {
+    NodeRef l, r;
+    split(m_nodes[n].left, pos, l, r);
+    m_nodes[n].left = r;
+    update(n);
+    left = l;
+    right = n;
+  } else if(pos >= left_len + piece_len) {
+    NodeRef l, r;
+    split(m_nodes[n].right, pos - left_len - piece_len, l, r);
+    m_nodes[n].right = l;
+    update(n);
+    left = n;
+    right = r;
+  } else {
+    // the split position is inside of this piece, cut it in two
+    const size_t cut = pos - left_len;
+
+    Piece tail = m_nodes[n].piece;
+    if(tail.kind != PieceKind_Fill)
+      tail.off += cut;
+    tail.len -= cut;
+
+    NodeRef m = createNode(tail);
+    // keeping the priority keeps the heap property for the right subtree
+    m_nodes[m].priority = m_nodes[n].priority;
+    m_nodes[m].right = m_nodes[n].right;
+    m_nodes[n].right = Null;
+    m_nodes[n].piece.len = cut;
+
+    update(m);
+    update(n);
+    left = n;
+    right = m;
+  }
+}
+
+io::PieceTable::NodeRef io::PieceTable::merge(NodeRef left, NodeRef right) {
+  if(left == Null)
+    return right;
+  if(right == Null)
+    return left;
+
+  if(m_nodes[left].priority > m_nodes[right].priority) {
+    NodeRef r = merge(m_nodes[left].right, right);
+    m_nodes[left].right = r;
+    update(left);
+    return left;
+  } else {
+    NodeRef l = merge(left, m_nodes[right].left);
+    m_nodes[right].left = l;
+    update(right);
+    return right;
+  }
+}
+
+io::PieceTable::NodeRef io::PieceTable::replace(size_t off, size_t len, NodeRef n) {
+  NodeRef a, b, removed, c;
+  split(m_root, off, a, b);
+  split(b, len, removed, c);
+  m_root = merge(merge(a, n), c);
+  return removed;
+}
+
+void io::PieceTable::setSource(DataSource* source) {
+  m_source = source;
+  reset();
+}
+
+void io::PieceTable::reset() {
+  m_undo.clear();
+  m_redo.clear();
+  m_nodes.resize(1);
+  m_free.clear();
+  m_added.clear();
+  m_added.shrink_to_fit();
+  m_root = Null;
+  m_base_state = m_saved_state = ++m_next_state;
+
+  if(m_source && m_source->size())
+    m_root = createNode(Piece{PieceKind_Original, 0, m_source->size(), 0});
+}
+
+void io::PieceTable::overwrite(size_t off, const uint8_t* data, size_t len) {
+  if(!len || off > size())
+    return;
+
+  NodeRef n = createNode(Piece{PieceKind_Added, m_added.size(), len, 0});
+  m_added.insert(m_added.end(), data, data + len);
+  record(off, len, replace(off, std::min(len, size() - off), n));
+}
+
+void io::PieceTable::insert(size_t off, const uint8_t* data, size_t len) {
+  if(!len || off > size())
+    return;
+
+  NodeRef n = createNode(Piece{PieceKind_Added, m_added.size(), len, 0});
+  m_added.insert(m_added.end(), data, data + len);
+  record(off, len, replace(off, 0, n));
+}
+
+void io::PieceTable::erase(size_t off, size_t len) {
+  if(off >= size())
+    return;
+
+  record(off, 0, replace(off, std::min(len, size() - off), Null));
+}
+
+void io::PieceTable::fill(size_t off, size_t len, uint8_t value) {
+  if(!len || off > size())
+    return;
+
+  NodeRef n = createNode(Piece{PieceKind_Fill, 0, len, value});
+  record(off, len, replace(off, std::min(len, size() - off), n));
+}
+
+void io::PieceTable::type(size_t off, uint8_t value, bool insert) {
+  if(off > size())
+    return;
+
+  NodeRef n = createNode(Piece{PieceKind_Added, m_added.size(), 1, 0});
+  m_added.push_back(value);
+
+  const size_t replaced = (insert || off == size()) ? 0 : 1;
+
+  Edit* last = (!m_undo.empty() && m_undo.back().typing && m_redo.empty()) ? &m_undo.back() : nullptr;
+  if(last && off >= last->off && off < last->off + last->len && !insert) {
+    // retyping a byte of the current run, the replaced byte was typed as well
+    freeTree(replace(off, 1, n));
+  } else if(last && off == last->off + last->len) {
+    // extending the current run, the replaced byte joins the pieces to restore
+    NodeRef removed = replace(off, replaced, n);
+    last->removed = merge(last->removed, removed);
+    last->len++;
+  } else {
+    record(off, 1, replace(off, replaced, n), true);
+  }
+}
+
+void io::PieceTable::endTyping() {
+  if(!m_undo.empty())
+    m_undo.back().typing = false;
+}
+
+void io::PieceTable::record(size_t off, size_t len, NodeRef removed, bool typing) {
+  clearRedo();
+  m_undo.push_back(Edit{off, len, removed, typing, ++m_next_state});
+}
+
+void io::PieceTable::clearRedo() {
+  for(auto& edit : m_redo)
+    freeTree(edit.removed);
+  m_redo.clear();
+}
+
+void io::PieceTable::clearHistory() {
+  m_base_state = state();
+  clearRedo();
+  for(auto& edit : m_undo)
+    freeTree(edit.removed);
+  m_undo.clear();
+}
+
+io::PieceTable::Edit io::PieceTable::apply(const Edit& edit) {
+  const size_t len = total(edit.removed);
+  NodeRef current = replace(edit.off, edit.len, edit.removed);
+  // undone edits keep their version, redoing them goes back to it
+  return Edit{edit.off, len, current, false, edit.state};
+}
+
+size_t io::PieceTable::undo() {
+  if(m_undo.empty())
+    return (size_t)-1;
+
+  Edit edit = m_undo.back();
+  m_undo.pop_back();
+  m_redo.push_back(apply(edit));
+  return edit.off;
+}
+
+size_t io::PieceTable::redo() {
+  if(m_redo.empty())
+    return (size_t)-1;
+
+  Edit edit = m_redo.back();
+  m_redo.pop_back();
+  m_undo.push_back(apply(edit));
+  return edit.off;
+}
+
+bool io::PieceTable::isModified() const {
+  // undoing every edit leaves the original split into several pieces, so the pieces can't tell
+  return state() != m_saved_state;
+}
+
+void io::PieceTable::walkTree(NodeRef n, size_t& pos,
+                              const std::function<void(size_t pos, const Piece& piece)>& func) const {
+  if(n == Null)
+    return;
+  walkTree(m_nodes[n].left, pos, func);
+  func(pos, m_nodes[n].piece);
+  pos += m_nodes[n].piece.len;
+  walkTree(m_nodes[n].right, pos, func);
+}
+
+void io::PieceTable::forEachPiece(const std::function<void(size_t pos, const Piece& piece)>& func) const {
+  size_t pos = 0;
+  walkTree(m_root, pos, func);
+}
+
+void io::PieceTable::visitRange(NodeRef n, size_t start, size_t off, size_t len, const RangeFn& func) const {
+  if(n == Null)
+    return;
+
+  const Node& node = m_nodes[n];
+  const size_t piece_start = start + total(node.left);
+  const size_t piece_end = piece_start + node.piece.len;
+
+  if(off < piece_start)
+    visitRange(node.left, start, off, len, func);
+
+  const size_t from = std::max(off, piece_start);
+  const size_t to = std::min(off + len, piece_end);
+  if(from < to)
+    func(node.piece, from - piece_start, from, to - from);
+
+  if(off + len > piece_end)
+    visitRange(node.right, piece_end, off, len, func);
+}
+
+size_t io::PieceTable::read(size_t off, uint8_t* dst, size_t len) {
+  if(off >= size())
+    return 0;
+
+  len = std::min(len, size() - off);
+  // the bytes up to a short read of the source, nothing after it is used
+  size_t done = len;
+  visitRange(m_root, 0, off, len, [&](const Piece& piece, size_t skip, size_t pos, size_t n) {
+    if(pos - off >= done)
+      return;
+    uint8_t* out = dst + (pos - off);
+    switch(piece.kind) {
+      case PieceKind_Original: {
+        const size_t got = m_source->read(piece.off + skip, out, n);
+        if(got < n)
+          done = pos - off + got;
+        break;
+      }
+      case PieceKind_Added:
+        memcpy(out, m_added.data() + piece.off + skip, n);
+        break;
+      case PieceKind_Fill:
+        memset(out, piece.fill, n);
+        break;
+    }
+  });
+  return done;
+}
+
+void io::PieceTable::prefetch(size_t off, size_t len) {
+  if(!m_source || off >= size())
+    return;
+
+  // only the original pieces are worth prefetching
+  len = std::min(len, size() - off);
+  visitRange(m_root, 0, off, len, [&](const Piece& piece, size_t skip, size_t pos, size_t n) {
+    (void)pos;
+    if(piece.kind == PieceKind_Original)
+      m_source->prefetch(piece.off + skip, n);
+  });
+}
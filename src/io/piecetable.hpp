@@ -0,0 +1,148 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include "datasource.hpp"
+
+namespace io {
+
+enum PieceKind { PieceKind_Original, PieceKind_Added, PieceKind_Fill };
+
+/*
+ * a run of bytes in the edited data.
+ *
+ * original pieces reference the unmodified source, added pieces the append-only add buffer and fill pieces repeat a
+ * single byte (so filling a huge range doesn't cost any memory).
+ * */
+struct Piece {
+  PieceKind kind;
+  size_t off;
+  size_t len;
+  uint8_t fill;
+};
+
+/*
+ * edit layer over a read-only data source.
+ *
+ * the pieces are kept in a treap ordered by position, every node knows the length of its subtree. looking up an
+ * offset, overwriting, inserting and erasing are O(log n) in the number of pieces and independent of the position
+ * or the size of the data.
+ *
+ * every edit is recorded for undo/redo as the position, the length of the new content and the detached subtree of
+ * the pieces it replaced. no bytes are copied, so undoing or redoing even a huge fill costs O(log n) time and a
+ * constant amount of memory. consecutive typed bytes are coalesced into one edit.
+ *
+ * the source isn't owned by the piece table.
+ * */
+class PieceTable : public DataSource {
+private:
+  typedef uint32_t NodeRef;
+  static const NodeRef Null = 0;
+
+  struct Node {
+    Piece piece;
+    NodeRef left, right;
+    uint32_t priority;
+    size_t total;
+  };
+
+  DataSource* m_source = nullptr;
+
+  // node 0 is the null node
+  std::vector<Node> m_nodes;
+  std::vector<NodeRef> m_free;
+  NodeRef m_root = Null;
+
+  std::vector<uint8_t> m_added;
+  uint32_t m_seed = 0x9e3779b9;
+
+  struct Edit {
+    // position & length of the content in the tree
+    size_t off;
+    size_t len;
+    // detached pieces which were replaced
+    NodeRef removed;
+    bool typing;
+    // the version of the data with the edit applied
+    uint64_t state;
+  };
+  std::vector<Edit> m_undo;
+  std::vector<Edit> m_redo;
+
+  // every edit makes a new version of the data, undo and redo go back to earlier ones. the data is modified
+  // unless it's at the version of the source
+  uint64_t m_next_state = 0;
+  // the version without any of the edits in the history
+  uint64_t m_base_state = 0;
+  // the version of the source, saving resets the table
+  uint64_t m_saved_state = 0;
+
+  uint64_t state() const { return m_undo.empty() ? m_base_state : m_undo.back().state; }
+
+  void record(size_t off, size_t len, NodeRef removed, bool typing = false);
+  void clearRedo();
+  // swaps the content of the edit with the detached pieces, returns the inverse edit
+  Edit apply(const Edit& edit);
+
+  NodeRef createNode(const Piece& piece);
+  void freeTree(NodeRef n);
+  void update(NodeRef n);
+
+  // splits n into the first pos bytes and the rest
+  void split(NodeRef n, size_t pos, NodeRef& left, NodeRef& right);
+  NodeRef merge(NodeRef left, NodeRef right);
+
+  // replaces len bytes at off with the tree n, returns the removed tree
+  NodeRef replace(size_t off, size_t len, NodeRef n);
+
+  // calls func for every piece overlapping [off, off+len) with the offset into the piece, the position and length
+  // of the overlap
+  typedef std::function<void(const Piece& piece, size_t skip, size_t pos, size_t len)> RangeFn;
+  void visitRange(NodeRef n, size_t start, size_t off, size_t len, const RangeFn& func) const;
+  void walkTree(NodeRef n, size_t& pos, const std::function<void(size_t pos, const Piece& piece)>& func) const;
+
+  size_t total(NodeRef n) const { return m_nodes[n].total; }
+
+public:
+  PieceTable();
+
+  // sets the original data and drops all edits
+  void setSource(DataSource* source);
+  DataSource* source() const { return m_source; }
+
+  // drops all edits
+  void reset();
+
+  void overwrite(size_t off, const uint8_t* data, size_t len);
+  void insert(size_t off, const uint8_t* data, size_t len);
+  void erase(size_t off, size_t len);
+  // overwrites len bytes at off with value
+  void fill(size_t off, size_t len, uint8_t value);
+
+  // sets one byte while typing, typing into or right after the previous typed bytes extends the same undo step
+  void type(size_t off, uint8_t value, bool insert);
+  // the next typed byte starts a new undo step
+  void endTyping();
+
+  // undo/redo the last edit, returns the position of the edit or (size_t)-1 if there was nothing to undo/redo
+  size_t undo();
+  size_t redo();
+  bool canUndo() const { return !m_undo.empty(); }
+  bool canRedo() const { return !m_redo.empty(); }
+  void clearHistory();
+
+  bool isModified() const;
+  size_t pieceCount() const { return m_nodes.size() - 1 - m_free.size(); }
+
+  // the add buffer the added pieces refer to, valid until the next edit
+  const uint8_t* added() const { return m_added.data(); }
+
+  // calls func for every piece in order, pos is the position of the piece in the edited data
+  void forEachPiece(const std::function<void(size_t pos, const Piece& piece)>& func) const;
+
+  size_t size() const override { return total(m_root); }
+  size_t read(size_t off, uint8_t* dst, size_t len) override;
+  void prefetch(size_t off, size_t len) override;
+};
+
+}
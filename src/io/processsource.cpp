@@ -0,0 +1,162 @@
+#include "processsource.hpp"
+#include <application/log.hpp>
+#include <algorithm>
+#include <fstream>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+static size_t pageSize() {
+  static size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  return page_size;
+}
+
+io::ProcessSource::~ProcessSource() { detach(); }
+
+bool io::ProcessSource::attach(pid_t pid) {
+  detach();
+
+  m_pid = pid;
+  if(!refresh()) {
+    m_pid = 0;
+    return false;
+  }
+
+  // only needed if process_vm_readv doesn't work, but opening it checks the permissions early
+  std::string mem_path = "/proc/" + std::to_string(pid) + "/mem";
+  m_mem_fd = ::open(mem_path.c_str(), O_RDONLY);
+  if(m_mem_fd < 0)
+    LOG_WARN("couldn't open " + mem_path + ": " + strerror(errno))
+
+  return true;
+}
+
+void io::ProcessSource::detach() {
+  if(m_mem_fd >= 0)
+    ::close(m_mem_fd);
+  m_mem_fd = -1;
+  m_pid = 0;
+  m_use_mem_file = false;
+  m_regions.clear();
+  m_segments.clear();
+  m_size = 0;
+}
+
+bool io::ProcessSource::refresh(bool* changed) {
+  std::string maps_path = "/proc/" + std::to_string(m_pid) + "/maps";
+  std::ifstream f(maps_path);
+  if(!f) {
+    LOG_ERROR("couldn't open " + maps_path)
+    return false;
+  }
+
+  std::vector<ProcessRegion> regions;
+  size_t size = 0;
+  std::string line;
+  while(std::getline(f, line)) {
+    ProcessRegion region;
+    int name_pos = 0;
+    if(sscanf(line.c_str(), "%zx-%zx %4s %*s %*s %*s %n", &region.start, &region.end, region.perms, &name_pos) < 3)
+      continue;
+    region.name = line.substr(std::min((size_t)name_pos, line.size()));
+
+    // the kernel's pages can't be read through the process
+    if(region.perms[0] != 'r' || region.name == "[vvar]" || region.name == "[vsyscall]")
+      continue;
+
+    region.offset = size;
+    size += region.end - region.start;
+    regions.push_back(region);
+  }
+
+  const bool same = regions.size() == m_regions.size() &&
+                    std::equal(regions.begin(), regions.end(), m_regions.begin(),
+                               [](const ProcessRegion& a, const ProcessRegion& b) {
+                                 return a.start == b.start && a.end == b.end && a.name == b.name;
+                               });
+  if(changed)
+    *changed = !same;
+  if(same)
+    return true;
+
+  m_regions.swap(regions);
+  m_size = size;
+  m_segments.clear();
+  for(auto& region : m_regions)
+    m_segments.add(region.start, region.end - region.start, region.name);
+  return true;
+}
+
+size_t io::ProcessSource::regionAt(size_t off) const {
+  auto it = std::upper_bound(m_regions.begin(), m_regions.end(), off,
+                             [](size_t o, const ProcessRegion& r) { return o < r.offset; });
+  return (size_t)(it - m_regions.begin()) - 1;
+}
+
+size_t io::ProcessSource::readRegion(const ProcessRegion& region, size_t skip, uint8_t* dst, size_t len) {
+  static const size_t MaxBatch = 64;
+  const size_t page = pageSize();
+
+  size_t done = 0;
+  while(done < len) {
+    const size_t addr = region.start + skip + done;
+
+    // one remote iovec per page, a partial read stops at the first unreadable page
+    struct iovec remote[MaxBatch];
+    size_t count = 0, batch = 0;
+    for(size_t a = addr; count < MaxBatch && done + batch < len; count++) {
+      size_t n = std::min(page - (a % page), len - done - batch);
+      remote[count].iov_base = (void*)a;
+      remote[count].iov_len = n;
+      batch += n;
+      a += n;
+    }
+    struct iovec local = { dst + done, batch };
+
+    ssize_t r;
+    size_t expected;
+    if(!m_use_mem_file) {
+      r = process_vm_readv(m_pid, &local, 1, remote, count, 0);
+      expected = batch;
+      if(r < 0 && errno == ENOSYS && m_mem_fd >= 0) {
+        m_use_mem_file = true;
+        continue;
+      }
+    } else {
+      r = pread(m_mem_fd, dst + done, remote[0].iov_len, (off_t)addr);
+      expected = remote[0].iov_len;
+    }
+
+    if(r < 0)
+      r = 0;
+    done += (size_t)r;
+
+    if((size_t)r < expected) {
+      // zero the page that couldn't be read and go on with the next one
+      size_t failed = std::min(page - ((addr + r) % page), len - done);
+      memset(dst + done, 0, failed);
+      done += failed;
+    }
+  }
+  return done;
+}
+
+size_t io::ProcessSource::read(size_t off, uint8_t* dst, size_t len) {
+  if(off >= m_size)
+    return 0;
+
+  len = std::min(len, m_size - off);
+
+  size_t done = 0;
+  for(size_t i = regionAt(off); done < len && i < m_regions.size(); i++) {
+    const ProcessRegion& region = m_regions[i];
+    const size_t skip = off + done - region.offset;
+    const size_t n = std::min(len - done, (region.end - region.start) - skip);
+    readRegion(region, skip, dst + done, n);
+    done += n;
+  }
+  return done;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <sys/types.h>
+#include "datasource.hpp"
+#include "segmentmap.hpp"
+
+namespace io {
+
+struct ProcessRegion {
+  size_t start, end;
+  // offset of the region in the data source
+  size_t offset;
+  char perms[5];
+  std::string name;
+};
+
+/*
+ * live memory of a local process.
+ *
+ * the readable mappings from /proc/<pid>/maps are laid out one after another, the holes in between aren't part of
+ * the data, the segment map translates the offsets back to the addresses in the process. reads are done with
+ * process_vm_readv() in page sized batches, so unreadable pages (guard pages, ...) are zero filled instead of failing
+ * the whole read. /proc/<pid>/mem is used if process_vm_readv isn't available.
+ *
+ * the memory changes all the time, so the source is volatile and mustn't be cached longer than a frame.
+ * */
+class ProcessSource : public DataSource {
+private:
+  pid_t m_pid = 0;
+  int m_mem_fd = -1;
+  // set by the first read which finds process_vm_readv missing, reads can come from several threads
+  std::atomic<bool> m_use_mem_file{false};
+  std::vector<ProcessRegion> m_regions;
+  SegmentMap m_segments;
+  size_t m_size = 0;
+
+  // index of the region containing off
+  size_t regionAt(size_t off) const;
+  size_t readRegion(const ProcessRegion& region, size_t skip, uint8_t* dst, size_t len);
+
+  ProcessSource(const ProcessSource&);
+  void operator=(const ProcessSource&);
+
+public:
+  ProcessSource() {}
+  ~ProcessSource();
+
+  bool attach(pid_t pid);
+  void detach();
+  // parses the memory map again, changed is set if the readable regions aren't the same anymore. nothing may read
+  // from the source meanwhile
+  bool refresh(bool* changed = nullptr);
+
+  pid_t pid() const { return m_pid; }
+  const std::vector<ProcessRegion>& regions() const { return m_regions; }
+
+  size_t size() const override { return m_size; }
+  size_t read(size_t off, uint8_t* dst, size_t len) override;
+  const SegmentMap* segments() const override { return &m_segments; }
+  bool isVolatile() const override { return true; }
+};
+
+}
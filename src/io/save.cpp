@@ -0,0 +1,206 @@
+#include "save.hpp"
+#include <application/log.hpp>
+#include <algorithm>
+#include <vector>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+static const size_t CopyChunk = 1024 * 1024;
+
+static bool writeAll(int fd, const uint8_t* buf, size_t len, size_t off) {
+  while(len) {
+    ssize_t r = pwrite(fd, buf, len, (off_t)off);
+    if(r < 0 && errno == EINTR)
+      continue;
+    if(r <= 0)
+      return false;
+    buf += r;
+    len -= (size_t)r;
+    off += (size_t)r;
+  }
+  return true;
+}
+
+// writes len bytes of the edited data at pos to out_pos in fd
+static bool writeEdited(io::PieceTable& edit, size_t pos, size_t len, int fd, size_t out_pos,
+                        std::vector<uint8_t>& buf) {
+  buf.resize(CopyChunk);
+  while(len) {
+    size_t n = edit.read(pos, buf.data(), std::min(len, buf.size()));
+    if(!n || !writeAll(fd, buf.data(), n, out_pos))
+      return false;
+    pos += n;
+    out_pos += n;
+    len -= n;
+  }
+  return true;
+}
+
+// copies unchanged data from the original file, in kernel if possible
+static bool copyOriginal(int src_fd, size_t src_off, int dst_fd, size_t dst_off, size_t len,
+                         std::vector<uint8_t>& buf) {
+  while(len) {
+    loff_t in = (loff_t)src_off, out = (loff_t)dst_off;
+    ssize_t r = copy_file_range(src_fd, &in, dst_fd, &out, len, 0);
+    if(r < 0 && errno == EINTR)
+      continue;
+    if(r <= 0)
+      break;
+    src_off += (size_t)r;
+    dst_off += (size_t)r;
+    len -= (size_t)r;
+  }
+
+  // not supported (old kernel, different file systems, ...), copy through userspace
+  buf.resize(CopyChunk);
+  while(len) {
+    ssize_t r = pread(src_fd, buf.data(), std::min(len, buf.size()), (off_t)src_off);
+    if(r < 0 && errno == EINTR)
+      continue;
+    if(r <= 0 || !writeAll(dst_fd, buf.data(), (size_t)r, dst_off))
+      return false;
+    src_off += (size_t)r;
+    dst_off += (size_t)r;
+    len -= (size_t)r;
+  }
+  return true;
+}
+
+static io::SaveResult saveInPlace(io::PieceTable& edit, const std::string& path) {
+  // merge adjacent dirty pieces (e.g. typed bytes) into extents
+  std::vector<std::pair<size_t, size_t>> extents;
+  edit.forEachPiece([&](size_t pos, const io::Piece& piece) {
+    if(piece.kind == io::PieceKind_Original)
+      return;
+    if(!extents.empty() && extents.back().first + extents.back().second == pos)
+      extents.back().second += piece.len;
+    else
+      extents.push_back(std::make_pair(pos, piece.len));
+  });
+
+  if(extents.empty())
+    return io::SaveResult_InPlace;
+
+  int fd = ::open(path.c_str(), O_WRONLY);
+  if(fd < 0) {
+    LOG_ERROR("couldn't open " + path + " for writing: " + strerror(errno))
+    return io::SaveResult_Failed;
+  }
+
+  std::vector<uint8_t> buf;
+  bool ok = true;
+  for(auto& extent : extents) {
+    if(!writeEdited(edit, extent.first, extent.second, fd, extent.first, buf)) {
+      LOG_ERROR("couldn't write " + path + ": " + strerror(errno))
+      ok = false;
+      break;
+    }
+  }
+
+  if(ok && fsync(fd) != 0) {
+    LOG_ERROR("couldn't sync " + path + ": " + strerror(errno))
+    ok = false;
+  }
+  ::close(fd);
+
+  return ok ? io::SaveResult_InPlace : io::SaveResult_Failed;
+}
+
+// creates a temporary file next to path with the permissions of path, returns the fd or -1
+static int createTemp(const std::string& path, std::string& tmp_path) {
+  struct stat st;
+  if(stat(path.c_str(), &st) != 0) {
+    LOG_ERROR("couldn't stat " + path + ": " + strerror(errno))
+    return -1;
+  }
+  if(!S_ISREG(st.st_mode)) {
+    LOG_ERROR("can't rewrite " + path + ", it's not a regular file")
+    return -1;
+  }
+
+  // the new file has to be in the same directory for an atomic rename
+  tmp_path = path + ".XXXXXX";
+  std::vector<char> tmp_name(tmp_path.begin(), tmp_path.end());
+  tmp_name.push_back(0);
+  int fd = mkstemp(tmp_name.data());
+  if(fd < 0) {
+    LOG_ERROR("couldn't create temporary file for " + path + ": " + strerror(errno))
+    return -1;
+  }
+  tmp_path = tmp_name.data();
+  fchmod(fd, st.st_mode & 07777);
+  return fd;
+}
+
+// syncs and closes the temporary file and renames it over path, it's removed if anything failed
+static bool commitTemp(int fd, const std::string& tmp_path, const std::string& path, bool ok) {
+  if(!ok)
+    LOG_ERROR("couldn't write " + tmp_path + ": " + strerror(errno))
+
+  if(ok && fsync(fd) != 0) {
+    LOG_ERROR("couldn't sync " + tmp_path + ": " + strerror(errno))
+    ok = false;
+  }
+  ::close(fd);
+
+  if(ok && rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG_ERROR("couldn't replace " + path + ": " + strerror(errno))
+    ok = false;
+  }
+  if(!ok)
+    unlink(tmp_path.c_str());
+  return ok;
+}
+
+static io::SaveResult saveRewrite(io::PieceTable& edit, const std::string& path) {
+  std::string tmp_path;
+  int fd = createTemp(path, tmp_path);
+  if(fd < 0)
+    return io::SaveResult_Failed;
+
+  const int src_fd = edit.source() ? edit.source()->fd() : -1;
+
+  std::vector<uint8_t> buf;
+  bool ok = true;
+  edit.forEachPiece([&](size_t pos, const io::Piece& piece) {
+    if(!ok)
+      return;
+    if(piece.kind == io::PieceKind_Original && src_fd >= 0)
+      ok = copyOriginal(src_fd, piece.off, fd, pos, piece.len, buf);
+    else
+      ok = writeEdited(edit, pos, piece.len, fd, pos, buf);
+  });
+
+  return commitTemp(fd, tmp_path, path, ok) ? io::SaveResult_Rewritten : io::SaveResult_Failed;
+}
+
+bool io::replaceFile(const std::string& path, const std::string& content) {
+  std::string tmp_path;
+  int fd = createTemp(path, tmp_path);
+  if(fd < 0)
+    return false;
+
+  bool ok = writeAll(fd, (const uint8_t*)content.data(), content.size(), 0);
+  return commitTemp(fd, tmp_path, path, ok);
+}
+
+io::SaveResult io::saveFile(PieceTable& edit, const std::string& path) {
+  const DataSource* original = edit.source();
+
+  // writing in place is only possible if no original data has to be read from a different position than it's
+  // written to, otherwise it might have been overwritten already
+  bool moved = false;
+  edit.forEachPiece([&](size_t pos, const Piece& piece) {
+    if(piece.kind == PieceKind_Original && piece.off != pos)
+      moved = true;
+  });
+
+  if(original && original->size() == edit.size() && !moved)
+    return saveInPlace(edit, path);
+
+  return saveRewrite(edit, path);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include "piecetable.hpp"
+
+namespace io {
+
+enum SaveResult { SaveResult_Failed, SaveResult_InPlace, SaveResult_Rewritten };
+
+/*
+ * writes the edited data to path, which has to be the file the original source was loaded from.
+ *
+ * if the length didn't change and no original data was moved, only the dirty extents (all pieces which aren't
+ * unmoved original data) are written in place with pwrite(). otherwise a new file is streamed next to the old one,
+ * the unchanged runs are copied with copy_file_range() and the new file is renamed over the old one atomically.
+ *
+ * after an in place save the source shows the new content (caches have to be invalidated), after a rewrite the
+ * file has to be opened again.
+ * */
+SaveResult saveFile(PieceTable& edit, const std::string& path);
+
+// replaces the regular file at path with content the same way, the permissions are kept
+bool replaceFile(const std::string& path, const std::string& content);
+
+}
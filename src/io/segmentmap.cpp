@@ -0,0 +1,60 @@
+#include "segmentmap.hpp"
+#include <algorithm>
+
+void io::SegmentMap::clear() {
+  m_segments.clear();
+  m_by_addr.clear();
+  m_size = 0;
+}
+
+void io::SegmentMap::add(uint64_t addr, size_t size, const std::string& name) {
+  m_segments.push_back(Segment{addr, m_size, size, name});
+  m_size += size;
+
+  uint32_t index = (uint32_t)m_segments.size() - 1;
+  auto it = std::upper_bound(m_by_addr.begin(), m_by_addr.end(), addr,
+                             [this](uint64_t a, uint32_t i) { return a < m_segments[i].addr; });
+  m_by_addr.insert(it, index);
+}
+
+size_t io::SegmentMap::segmentAt(size_t off) const {
+  auto it = std::upper_bound(m_segments.begin(), m_segments.end(), off,
+                             [](size_t o, const Segment& s) { return o < s.offset; });
+  return it == m_segments.begin() ? 0 : (size_t)(it - m_segments.begin()) - 1;
+}
+
+uint64_t io::SegmentMap::addressOf(size_t off) const {
+  if(m_segments.empty())
+    return off;
+  const Segment& s = m_segments[segmentAt(off)];
+  return s.addr + (off - s.offset);
+}
+
+bool io::SegmentMap::offsetOf(uint64_t addr, size_t& off) const {
+  // first segment starting above addr, the one before might contain it
+  auto it = std::upper_bound(m_by_addr.begin(), m_by_addr.end(), addr,
+                             [this](uint64_t a, uint32_t i) { return a < m_segments[i].addr; });
+
+  if(it != m_by_addr.begin()) {
+    const Segment& s = m_segments[*(it - 1)];
+    if(addr - s.addr < s.size) {
+      off = s.offset + (size_t)(addr - s.addr);
+      return true;
+    }
+  }
+
+  off = (it != m_by_addr.end()) ? m_segments[*it].offset : m_size;
+  return false;
+}
+
+uint64_t io::SegmentMap::minAddress() const {
+  return m_by_addr.empty() ? 0 : m_segments[m_by_addr.front()].addr;
+}
+
+uint64_t io::SegmentMap::maxAddress() const {
+  uint64_t max = 0;
+  for(auto& s : m_segments)
+    if(s.size)
+      max = std::max(max, s.addr + s.size - 1);
+  return max;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace io {
+
+struct Segment {
+  uint64_t addr;
+  size_t offset;
+  size_t size;
+  std::string name;
+};
+
+/*
+ * maps the offsets of a data source to (virtual) addresses.
+ *
+ * the segments are laid out one after another in the data, in the address space there can be holes of any size
+ * between them. both directions are binary searches, so the mapping can be done for every visible row.
+ * */
+class SegmentMap {
+private:
+  // ordered by offset
+  std::vector<Segment> m_segments;
+  // segment indices ordered by address
+  std::vector<uint32_t> m_by_addr;
+  size_t m_size = 0;
+
+public:
+  void clear();
+  // appends a segment of size bytes at the end of the data
+  void add(uint64_t addr, size_t size, const std::string& name = "");
+
+  bool empty() const { return m_segments.empty(); }
+  const std::vector<Segment>& segments() const { return m_segments; }
+
+  // index of the segment containing off, the last segment for offsets past the end
+  size_t segmentAt(size_t off) const;
+  uint64_t addressOf(size_t off) const;
+
+  // offset of addr, returns false if addr is in a hole, off is set to the start of the next segment then (or the
+  // end of the data)
+  bool offsetOf(uint64_t addr, size_t& off) const;
+
+  uint64_t minAddress() const;
+  uint64_t maxAddress() const;
+};
+
+}
@@ -0,0 +1,62 @@
+#include "snapshot.hpp"
+#include <algorithm>
+#include <string.h>
+
+io::Snapshot::Snapshot(const PieceTable& edit, DataSource* original) : m_source(original), m_size(edit.size()) {
+  edit.forEachPiece([&](size_t pos, const Piece& piece) {
+    Piece copy = piece;
+    if(piece.kind == PieceKind_Added) {
+      copy.off = m_added.size();
+      m_added.insert(m_added.end(), edit.added() + piece.off, edit.added() + piece.off + piece.len);
+    }
+    m_starts.push_back(pos);
+    m_pieces.push_back(copy);
+  });
+}
+
+size_t io::Snapshot::read(size_t off, uint8_t* dst, size_t len) {
+  if(off >= m_size)
+    return 0;
+  len = std::min(len, m_size - off);
+
+  // piece containing off
+  size_t i = (size_t)(std::upper_bound(m_starts.begin(), m_starts.end(), off) - m_starts.begin()) - 1;
+  for(size_t done = 0; done < len; i++) {
+    const Piece& piece = m_pieces[i];
+    const size_t skip = off + done - m_starts[i];
+    const size_t n = std::min(len - done, piece.len - skip);
+    switch(piece.kind) {
+      case PieceKind_Original: {
+        // nothing after a short read is used
+        const size_t got = m_source->read(piece.off + skip, dst + done, n);
+        if(got < n)
+          return done + got;
+        break;
+      }
+      case PieceKind_Added:
+        memcpy(dst + done, m_added.data() + piece.off + skip, n);
+        break;
+      case PieceKind_Fill:
+        memset(dst + done, piece.fill, n);
+        break;
+    }
+    done += n;
+  }
+  return len;
+}
+
+void io::Snapshot::prefetch(size_t off, size_t len) {
+  if(off >= m_size)
+    return;
+  len = std::min(len, m_size - off);
+
+  size_t i = (size_t)(std::upper_bound(m_starts.begin(), m_starts.end(), off) - m_starts.begin()) - 1;
+  for(size_t done = 0; done < len; i++) {
+    const Piece& piece = m_pieces[i];
+    const size_t skip = off + done - m_starts[i];
+    const size_t n = std::min(len - done, piece.len - skip);
+    if(piece.kind == PieceKind_Original)
+      m_source->prefetch(piece.off + skip, n);
+    done += n;
+  }
+}
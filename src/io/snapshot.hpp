@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include "datasource.hpp"
+#include "piecetable.hpp"
+
+namespace io {
+
+/*
+ * frozen copy of the edited data, for reading on worker threads.
+ *
+ * only the piece list and the added bytes are copied, the original data is read from the source the edits were
+ * made on (not through the page cache, which isn't thread safe). reads don't modify anything, so any number of
+ * threads can read at once as long as the reads of the original source are thread safe (all the file and process
+ * sources are).
+ *
+ * the original source isn't owned and has to outlive the snapshot. edits made after the snapshot was taken aren't
+ * visible in it.
+ * */
+class Snapshot : public DataSource {
+private:
+  DataSource* m_source = nullptr;
+  // start of every piece, the pieces reference m_added instead of the add buffer of the piece table
+  std::vector<size_t> m_starts;
+  std::vector<Piece> m_pieces;
+  std::vector<uint8_t> m_added;
+  size_t m_size = 0;
+
+  Snapshot(const Snapshot&);
+  void operator=(const Snapshot&);
+
+public:
+  Snapshot(const PieceTable& edit, DataSource* original);
+
+  size_t size() const override { return m_size; }
+  size_t read(size_t off, uint8_t* dst, size_t len) override;
+  void prefetch(size_t off, size_t len) override;
+};
+
+}
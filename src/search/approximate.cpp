@@ -0,0 +1,211 @@
+#include "approximate.hpp"
+#include "scanner.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SEARCH_HAVE_AVX2 1
+#endif
+
+const size_t search::ApproximateMatcher::MaxLength;
+
+bool search::ApproximateMatcher::setup(const Pattern& pattern, DistanceUnit unit, uint32_t max_distance) {
+  m_pattern = pattern;
+  m_unit = unit;
+  const size_t size = pattern.size();
+  if(!size || size > MaxLength)
+    return false;
+
+  // more than that would match everywhere
+  const size_t limit = unit == DistanceUnit_Bits ? size * 8 : size;
+  m_max_distance = (uint32_t)std::min((size_t)max_distance, limit);
+
+  for(int c = 0; c < 256; c++) {
+    uint64_t bits = ~0ull;
+    for(size_t i = 0; i < size; i++)
+      if((c & pattern.mask()[i]) == pattern.value()[i])
+        bits &= ~(1ull << i);
+    m_table[c] = bits;
+  }
+
+  m_words.assign((size + 7) / 8, 0);
+  m_masks.assign((size + 7) / 8, 0);
+  for(size_t i = 0; i < size; i++) {
+    m_words[i / 8] |= (uint64_t)pattern.value()[i] << (i % 8 * 8);
+    m_masks[i / 8] |= (uint64_t)pattern.mask()[i] << (i % 8 * 8);
+  }
+
+  m_names.clear();
+  for(uint32_t d = 0; d <= m_max_distance; d++)
+    m_names.push_back(std::to_string(d) + (unit == DistanceUnit_Bits ? " bits" : " bytes") + " off");
+  return true;
+}
+
+void search::ApproximateMatcher::scan(const uint8_t* data, size_t len, size_t count, size_t base,
+                                      std::vector<Hit>& hits) const {
+  if(m_unit == DistanceUnit_Bits)
+    scanBits(data, len, count, base, hits);
+  else
+    scanBytes(data, len, count, base, hits);
+}
+
+// with the number of mismatches known at compile time the state words stay in registers
+template<uint32_t K>
+static void shiftOr(const uint8_t* data, size_t end, size_t base, size_t size, const uint64_t* table, uint32_t k,
+                    std::vector<search::Hit>& hits) {
+  const uint32_t count = K ? K : k;
+  const uint64_t last = 1ull << (size - 1);
+
+  uint64_t state[K ? K + 1 : search::ApproximateMatcher::MaxLength + 1];
+  std::fill(state, state + count + 1, ~0ull);
+  for(size_t i = 0; i < end; i++) {
+    const uint64_t bits = table[data[i]];
+    // one more mismatch: the prefix before had to match with one less
+    uint64_t fewer = state[0];
+    state[0] = (state[0] << 1) | bits;
+    for(uint32_t j = 1; j <= count; j++) {
+      const uint64_t old = state[j];
+      state[j] = ((old << 1) | bits) & (fewer << 1);
+      fewer = old;
+    }
+
+    if(!(state[count] & last) && i + 1 >= size) {
+      uint32_t distance = 0;
+      while(state[distance] & last)
+        distance++;
+      hits.push_back(search::Hit{base + i + 1 - size, (uint32_t)size, distance});
+    }
+  }
+}
+
+#ifdef SEARCH_HAVE_AVX2
+// distances of 32 positions at once, one compare per pattern byte. mismatches pile up fast in random data, so
+// most blocks are given up after a few bytes. returns where the scalar code has to go on
+__attribute__((target("avx2")))
+static size_t scanAvx2(const search::Pattern& pattern, bool bits, uint32_t k, const uint8_t* data, size_t len,
+                       size_t count, size_t base, std::vector<search::Hit>& hits) {
+  const size_t size = pattern.size();
+  // wildcards are skipped
+  size_t used[search::ApproximateMatcher::MaxLength];
+  __m256i values[search::ApproximateMatcher::MaxLength], masks[search::ApproximateMatcher::MaxLength];
+  size_t n = 0;
+  for(size_t j = 0; j < size; j++) {
+    if(!pattern.mask()[j])
+      continue;
+    used[n] = j;
+    values[n] = _mm256_set1_epi8((char)pattern.value()[j]);
+    masks[n] = _mm256_set1_epi8((char)pattern.mask()[j]);
+    n++;
+  }
+
+  const __m256i limit = _mm256_set1_epi8((char)k);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi8(1);
+  const __m256i nibble = _mm256_set1_epi8(0x0F);
+  const __m256i ones = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+
+  size_t i = 0;
+  for(; i < count && i + 32 + size - 1 <= len; i += 32) {
+    // saturates at 255, k is below that
+    __m256i distance = zero;
+    for(size_t j = 0; j < n; j++) {
+      const __m256i x = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(data + i + used[j])), masks[j]);
+      if(bits) {
+        const __m256i d = _mm256_xor_si256(x, values[j]);
+        distance = _mm256_adds_epu8(distance, _mm256_shuffle_epi8(ones, _mm256_and_si256(d, nibble)));
+        distance = _mm256_adds_epu8(distance,
+                                    _mm256_shuffle_epi8(ones, _mm256_and_si256(_mm256_srli_epi16(d, 4), nibble)));
+      } else {
+        distance = _mm256_adds_epu8(distance, _mm256_andnot_si256(_mm256_cmpeq_epi8(x, values[j]), one));
+      }
+      if((j & 3) == 3 && !_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_subs_epu8(distance, limit), zero)))
+        break;
+    }
+
+    uint32_t found = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_subs_epu8(distance, limit), zero));
+    if(count - i < 32)
+      found &= (1u << (count - i)) - 1;
+    if(!found)
+      continue;
+
+    uint8_t distances[32];
+    _mm256_storeu_si256((__m256i*)distances, distance);
+    while(found) {
+      const size_t lane = (size_t)__builtin_ctz(found);
+      hits.push_back(search::Hit{base + i + lane, (uint32_t)size, distances[lane]});
+      found &= found - 1;
+    }
+  }
+  return i;
+}
+#endif
+
+void search::ApproximateMatcher::scanBytes(const uint8_t* data, size_t len, size_t count, size_t base,
+                                           std::vector<Hit>& hits) const {
+  const size_t size = m_pattern.size();
+  size_t done = 0;
+#ifdef SEARCH_HAVE_AVX2
+  if(hasAvx2())
+    done = scanAvx2(m_pattern, false, m_max_distance, data, len, count, base, hits);
+#endif
+  if(done >= count)
+    return;
+
+  // the last match can end at count + size - 2
+  const uint8_t* rest = data + done;
+  const size_t end = std::min(len, count + size - 1) - done;
+  base += done;
+  switch(m_max_distance) {
+  case 0: shiftOr<0>(rest, end, base, size, m_table, 0, hits); break;
+  case 1: shiftOr<1>(rest, end, base, size, m_table, 1, hits); break;
+  case 2: shiftOr<2>(rest, end, base, size, m_table, 2, hits); break;
+  case 3: shiftOr<3>(rest, end, base, size, m_table, 3, hits); break;
+  case 4: shiftOr<4>(rest, end, base, size, m_table, 4, hits); break;
+  default: shiftOr<0>(rest, end, base, size, m_table, m_max_distance, hits); break;
+  }
+}
+
+// the popcnt instruction is a lot faster than the generic popcount, the clone is picked when the program starts
+__attribute__((target_clones("popcnt", "default")))
+static void countBits(const uint8_t* data, size_t len, size_t end, size_t base, size_t size, const uint64_t* words,
+                      const uint64_t* masks, size_t word_count, uint32_t k, std::vector<search::Hit>& hits) {
+  // positions whose last word would be read past the end are compared from a zero padded copy
+  uint8_t tail[search::ApproximateMatcher::MaxLength + 8] = {};
+  for(size_t i = 0; i < end; i++) {
+    const uint8_t* p = data + i;
+    if(i + word_count * 8 > len) {
+      memcpy(tail, p, len - i);
+      p = tail;
+    }
+
+    uint32_t distance = 0;
+    for(size_t w = 0; w < word_count && distance <= k; w++) {
+      uint64_t v;
+      memcpy(&v, p + w * 8, sizeof(v));
+      distance += (uint32_t)__builtin_popcountll((v ^ words[w]) & masks[w]);
+    }
+    if(distance <= k)
+      hits.push_back(search::Hit{base + i, (uint32_t)size, distance});
+  }
+}
+
+void search::ApproximateMatcher::scanBits(const uint8_t* data, size_t len, size_t count, size_t base,
+                                          std::vector<Hit>& hits) const {
+  const size_t size = m_pattern.size();
+  if(len < size)
+    return;
+  const size_t end = std::min(count, len - size + 1);
+
+  size_t done = 0;
+#ifdef SEARCH_HAVE_AVX2
+  // the byte counters saturate at 255
+  if(hasAvx2() && m_max_distance < 255)
+    done = scanAvx2(m_pattern, true, m_max_distance, data, len, count, base, hits);
+#endif
+  if(done >= end)
+    return;
+  countBits(data + done, len - done, end - done, base + done, size, m_words.data(), m_masks.data(), m_words.size(),
+            m_max_distance, hits);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "matcher.hpp"
+#include "pattern.hpp"
+
+namespace search {
+
+enum DistanceUnit { DistanceUnit_Bytes, DistanceUnit_Bits };
+
+/*
+ * finds everything which differs from a pattern in at most a given number of bytes or bits (hamming distance).
+ *
+ * bytes: bit parallel shift-or with one state word per allowed mismatch, bit i of state j is clear if the last
+ * i + 1 bytes match the start of the pattern with at most j mismatches. that's k + 1 shifts and ors per byte.
+ * bits: the pattern is xored with the data 8 bytes at a time and the differing bits are counted with popcount,
+ * a position is given up once it's over the limit.
+ *
+ * wildcards of the pattern always match. the tag of a hit is its distance.
+ * */
+class ApproximateMatcher : public Matcher {
+private:
+  Pattern m_pattern;
+  DistanceUnit m_unit = DistanceUnit_Bytes;
+  uint32_t m_max_distance = 0;
+
+  // shift-or: bit i of m_table[c] is clear if c matches pattern byte i
+  uint64_t m_table[256];
+  // popcount: the pattern in 64 bit words, the mask is 0 for wildcards and past the end
+  std::vector<uint64_t> m_words;
+  std::vector<uint64_t> m_masks;
+
+  std::vector<std::string> m_names;
+
+  void scanBytes(const uint8_t* data, size_t len, size_t count, size_t base, std::vector<Hit>& hits) const;
+  void scanBits(const uint8_t* data, size_t len, size_t count, size_t base, std::vector<Hit>& hits) const;
+
+public:
+  static const size_t MaxLength = 64;
+
+  // false if the pattern is empty or longer than MaxLength
+  bool setup(const Pattern& pattern, DistanceUnit unit, uint32_t max_distance);
+
+  size_t length() const override { return m_pattern.size(); }
+  void scan(const uint8_t* data, size_t len, size_t count, size_t base, std::vector<Hit>& hits) const override;
+  const char* name(const Hit& hit) const override { return m_names[hit.tag].c_str(); }
+  bool ranked() const override { return true; }
+};
+
+}
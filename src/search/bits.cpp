@@ -0,0 +1,148 @@
+#include "bits.hpp"
+#include "scanner.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SEARCH_HAVE_AVX2 1
+#endif
+
+const size_t search::BitPatternMatcher::MaxBits;
+
+bool search::BitPatternMatcher::parse(const std::string& text) {
+  uint64_t value = 0, mask = 0;
+  m_bits = 0;
+  for(char c : text) {
+    if(c == ' ' || c == '_')
+      continue;
+    if((c != '0' && c != '1' && c != '?') || m_bits == MaxBits) {
+      m_bits = 0;
+      return false;
+    }
+    // from the top bit down
+    const uint64_t bit = 1ull << (63 - m_bits);
+    if(c == '1')
+      value |= bit;
+    if(c != '?')
+      mask |= bit;
+    m_bits++;
+  }
+  if(!mask) {
+    m_bits = 0;
+    return false;
+  }
+
+  memset(m_candidates, 0, sizeof(m_candidates));
+  for(int p = 0; p < 8; p++) {
+    m_value[p] = value >> p;
+    m_mask[p] = mask >> p;
+
+    // the first or the second byte of the window, whichever has more pattern bits
+    const int first = __builtin_popcountll(m_mask[p] >> 56);
+    const int second = __builtin_popcountll((m_mask[p] >> 48) & 0xFF);
+    const int anchor = second > first ? 1 : 0;
+    const uint8_t v = (uint8_t)(m_value[p] >> (56 - anchor * 8));
+    const uint8_t m = (uint8_t)(m_mask[p] >> (56 - anchor * 8));
+    for(int c = 0; c < 256; c++)
+      if((c & m) == v)
+        m_candidates[anchor][c] |= (uint8_t)(1 << p);
+    for(int b = 0; b < 2; b++) {
+      m_head_value[b][p] = (uint8_t)(m_value[p] >> (56 - b * 8));
+      m_head_mask[b][p] = (uint8_t)(m_mask[p] >> (56 - b * 8));
+    }
+  }
+  return true;
+}
+
+const char* search::BitPatternMatcher::name(const Hit& hit) const {
+  static const char* names[8] = {"bit 0", "bit 1", "bit 2", "bit 3", "bit 4", "bit 5", "bit 6", "bit 7"};
+  return names[hit.tag & 7];
+}
+
+// tests the phases at data[0], the window has to be readable
+static inline void verify(const uint8_t* window_data, uint32_t phases, size_t available, size_t base, size_t bits,
+                          const uint64_t* value, const uint64_t* mask, std::vector<search::Hit>& hits) {
+  uint64_t window;
+  memcpy(&window, window_data, sizeof(window));
+  window = __builtin_bswap64(window);
+
+  while(phases) {
+    const uint32_t p = (uint32_t)__builtin_ctz(phases);
+    phases &= phases - 1;
+    const size_t span = (p + bits + 7) / 8;
+    if(!((window ^ value[p]) & mask[p]) && span <= available)
+      hits.push_back(search::Hit{base, (uint32_t)span, p});
+  }
+}
+
+#ifdef SEARCH_HAVE_AVX2
+// positions where the first two bytes of any phase match, 32 at once. returns where the scalar code has to go on
+__attribute__((target("avx2")))
+size_t search::BitPatternMatcher::scanAvx2(const uint8_t* data, size_t len, size_t count, size_t base,
+                                           std::vector<Hit>& hits) const {
+  __m256i values[2][8], masks[2][8];
+  for(int b = 0; b < 2; b++) {
+    for(int p = 0; p < 8; p++) {
+      values[b][p] = _mm256_set1_epi8((char)m_head_value[b][p]);
+      masks[b][p] = _mm256_set1_epi8((char)m_head_mask[b][p]);
+    }
+  }
+
+  size_t i = 0;
+  for(; i < count && i + 32 + 8 <= len; i += 32) {
+    const __m256i bytes[2] = {_mm256_loadu_si256((const __m256i*)(data + i)),
+                              _mm256_loadu_si256((const __m256i*)(data + i + 1))};
+    __m256i any = _mm256_setzero_si256();
+    for(int p = 0; p < 8; p++)
+      any = _mm256_or_si256(any, _mm256_and_si256(
+                                     _mm256_cmpeq_epi8(_mm256_and_si256(bytes[0], masks[0][p]), values[0][p]),
+                                     _mm256_cmpeq_epi8(_mm256_and_si256(bytes[1], masks[1][p]), values[1][p])));
+
+    uint32_t found = (uint32_t)_mm256_movemask_epi8(any);
+    if(count - i < 32)
+      found &= (1u << (count - i)) - 1;
+    while(found) {
+      const size_t pos = i + (size_t)__builtin_ctz(found);
+      found &= found - 1;
+      verify(data + pos, m_candidates[0][data[pos]] | m_candidates[1][data[pos + 1]], len - pos, base + pos, m_bits,
+             m_value, m_mask, hits);
+    }
+  }
+  return i;
+}
+#endif
+
+void search::BitPatternMatcher::scan(const uint8_t* data, size_t len, size_t count, size_t base,
+                                     std::vector<Hit>& hits) const {
+  if(!m_bits || !len)
+    return;
+
+  const size_t end = std::min(count, len);
+  const uint8_t* first = m_candidates[0];
+  const uint8_t* second = m_candidates[1];
+  size_t i = 0;
+#ifdef SEARCH_HAVE_AVX2
+  if(hasAvx2())
+    i = scanAvx2(data, len, count, base, hits);
+#endif
+  for(; i < end && i + 8 <= len; i++) {
+    const uint32_t phases = first[data[i]] | second[data[i + 1]];
+    if(phases)
+      verify(data + i, phases, len - i, base + i, m_bits, m_value, m_mask, hits);
+  }
+
+  if(i >= end)
+    return;
+
+  // the last windows are read from a zero padded copy, what's past the end can't be part of a match
+  uint8_t tail[16] = {};
+  const size_t start = i;
+  memcpy(tail, data + start, len - start);
+  for(; i < end; i++) {
+    const uint8_t* t = tail + (i - start);
+    const uint32_t phases = first[t[0]] | second[t[1]];
+    if(phases)
+      verify(t, phases, len - i, base + i, m_bits, m_value, m_mask, hits);
+  }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include "matcher.hpp"
+
+namespace search {
+
+/*
+ * finds a bit pattern at any bit offset, the bits of a byte are counted from the most significant one.
+ *
+ * the pattern is kept shifted to all 8 phases as 64 bit words, a window of 8 data bytes (read big endian, so the
+ * bits are in order) matches phase p if (window ^ value[p]) & mask[p] == 0. to not do that for every byte, the
+ * byte which holds most pattern bits in each phase is looked up in a table first, which gives the phases that
+ * might match there. with AVX2 the first two bytes of all phases are compared for 32 positions at once
+ * instead.
+ *
+ * the offset of a hit is the byte the pattern starts in, its tag is the bit (0-7) it starts at.
+ * */
+class BitPatternMatcher : public Matcher {
+private:
+  size_t m_bits = 0;
+  uint64_t m_value[8], m_mask[8];
+  // phases whose anchor byte (the first or the second byte of the window) might match, by byte value
+  uint8_t m_candidates[2][256];
+  // first two bytes of the window for every phase
+  uint8_t m_head_value[2][8], m_head_mask[2][8];
+
+  size_t scanAvx2(const uint8_t* data, size_t len, size_t count, size_t base, std::vector<Hit>& hits) const;
+
+public:
+  // a phase and the pattern have to fit in 64 bits
+  static const size_t MaxBits = 57;
+
+  // text of 0, 1 and ? (any bit), spaces and _ are ignored. false if it isn't valid, has no 0 or 1 or is longer
+  // than MaxBits
+  bool parse(const std::string& text);
+  size_t bits() const { return m_bits; }
+
+  size_t length() const override { return (7 + m_bits + 7) / 8; }
+  void scan(const uint8_t* data, size_t len, size_t count, size_t base, std::vector<Hit>& hits) const override;
+  const char* name(const Hit& hit) const override;
+};
+
+}
@@ -0,0 +1,121 @@
+#include "blockindex.hpp"
+#include <application/log.hpp>
+#include <algorithm>
+#include <string.h>
+#include <sys/stat.h>
+
+const size_t search::BlockIndex::BlockSize;
+const size_t search::BlockIndex::FilterBytes;
+const size_t search::BlockIndex::Rows;
+
+struct IndexHeader {
+  char magic[8];
+  uint64_t data_size;
+  int64_t stamp;
+  uint32_t block_size;
+  uint32_t filter_bytes;
+};
+
+static const char IndexMagic[8] = {'h', 'e', 'x', 'x', 'i', 'd', 'x', '2'};
+
+size_t search::BlockIndex::headerSize() {
+  return sizeof(IndexHeader);
+}
+
+std::string search::BlockIndex::header(size_t data_size, int64_t stamp) {
+  IndexHeader header;
+  memcpy(header.magic, IndexMagic, sizeof(header.magic));
+  header.data_size = data_size;
+  header.stamp = stamp;
+  header.block_size = (uint32_t)BlockSize;
+  header.filter_bytes = (uint32_t)FilterBytes;
+  return std::string((const char*)&header, sizeof(header));
+}
+
+void search::BlockIndex::addBlock(const uint8_t* data, size_t len, size_t available, uint8_t* filter) {
+  const size_t end = std::min(len, available >= 2 ? available - 2 : 0);
+  for(size_t i = 0; i < end; i++) {
+    const uint32_t h = hash(data + i);
+    filter[h / 8] |= (uint8_t)(1 << (h % 8));
+  }
+}
+
+void search::BlockIndex::storeBlocks(const uint8_t* filters, size_t count, size_t block, size_t row_bytes,
+                                     uint8_t* rows) {
+  // every row gets a byte for each 8 blocks
+  for(size_t bit = 0; bit < Rows; bit++) {
+    const size_t byte = bit / 8;
+    const uint8_t mask = (uint8_t)(1 << (bit % 8));
+    uint8_t* row = rows + bit * row_bytes + block / 8;
+    for(size_t b = 0; b < count; b += 8) {
+      uint8_t out = 0;
+      for(size_t i = 0; i < 8 && b + i < count; i++)
+        out |= (filters[(b + i) * FilterBytes + byte] & mask) ? (uint8_t)(1 << i) : 0;
+      row[b / 8] = out;
+    }
+  }
+}
+
+int64_t search::BlockIndex::stamp(const std::string& path) {
+  struct stat st;
+  if(stat(path.c_str(), &st) != 0)
+    return 0;
+  return (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+bool search::BlockIndex::load(const std::string& path, size_t data_size, int64_t stamp) {
+  struct stat st;
+  if(stat(path.c_str(), &st) != 0 || !m_file.open(path))
+    return false;
+
+  IndexHeader header;
+  if(m_file.size() < sizeof(header)) {
+    m_file.close();
+    return false;
+  }
+  memcpy(&header, m_file.data(), sizeof(header));
+  if(memcmp(header.magic, IndexMagic, sizeof(header.magic)) || header.block_size != BlockSize ||
+     header.filter_bytes != FilterBytes || header.data_size != data_size || header.stamp != stamp ||
+     m_file.size() != fileSize(data_size)) {
+    LOG_WARN(path + " is out of date, it's not used")
+    m_file.close();
+    return false;
+  }
+
+  // queries only read the rows of their trigrams
+  m_file.advise(io::AccessHint_Random);
+  m_rows = m_file.data() + sizeof(header);
+  m_row_bytes = rowBytes(data_size);
+  m_data_size = data_size;
+  m_blocks = blockCount(data_size);
+  return true;
+}
+
+bool search::BlockIndex::possible(size_t block, const std::vector<uint32_t>& hashes, size_t length) const {
+  // a match could reach past the next block, or has nothing to look for
+  if(hashes.empty() || length > BlockSize || block >= m_blocks)
+    return true;
+
+  // the trigrams before the block border have to be in this block, the ones after it in the next one
+  size_t i = 0;
+  while(i < hashes.size() && contains(block, hashes[i]))
+    i++;
+  if(i == hashes.size())
+    return true;
+  if(block + 1 >= m_blocks)
+    return false;
+  for(; i < hashes.size(); i++)
+    if(!contains(block + 1, hashes[i]))
+      return false;
+  return true;
+}
+
+std::vector<uint32_t> search::trigramHashes(const Pattern& pattern) {
+  std::vector<uint32_t> hashes;
+  for(size_t i = 0; i + 3 <= pattern.size(); i++) {
+    const uint8_t* mask = pattern.mask() + i;
+    if(mask[0] == 0xFF && mask[1] == 0xFF && mask[2] == 0xFF)
+      hashes.push_back(BlockIndex::hash(pattern.value() + i));
+  }
+  return hashes;
+}
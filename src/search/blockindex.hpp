@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+#include <io/mappedfile.hpp>
+#include "pattern.hpp"
+
+namespace search {
+
+/*
+ * which 3 byte sequences (trigrams) occur in each block of the data, a bloom filter per block.
+ *
+ * every trigram starting in a block sets one bit of the block's filter. something that has to contain a list of
+ * trigrams can only start in a block if they're all in its filter, or the first ones are in its filter and the
+ * rest in the next block's (the match crosses into the next block). a bit is set for a random trigram with a
+ * probability of 1 - e^(-distinct trigrams / filter bits), so even blocks of random data are skipped for a
+ * pattern of a dozen bytes most of the time, blocks of code, text or padding nearly always.
+ *
+ * the filters take 1/16 of the data. they're stored transposed: a row per filter bit with that bit of every
+ * block, so a search only reads the rows of its trigrams (blocks / 8 bytes each) and not the whole index. the rows
+ * are stored in a file, which is mapped when it's loaded again, together with the size and modification time of
+ * the data so a stale index isn't used.
+ * */
+class BlockIndex {
+private:
+  io::MappedFile m_file;
+  const uint8_t* m_rows = nullptr;
+  size_t m_row_bytes = 0;
+  size_t m_data_size = 0;
+  size_t m_blocks = 0;
+
+  BlockIndex(const BlockIndex&);
+  void operator=(const BlockIndex&);
+
+public:
+  static const size_t BlockSize = 64 * 1024;
+  // of the filter of a block, it has a row per bit
+  static const size_t FilterBytes = 4096;
+  static const size_t Rows = FilterBytes * 8;
+
+  // bit of a trigram in the filters
+  static uint32_t hash(const uint8_t* trigram) {
+    const uint32_t t = trigram[0] | (uint32_t)trigram[1] << 8 | (uint32_t)trigram[2] << 16;
+    return (t * 2654435761u) >> (32 - 15);
+  }
+  static size_t blockCount(size_t data_size) { return (data_size + BlockSize - 1) / BlockSize; }
+  // bytes of a row, a bit per block padded to 64 blocks
+  static size_t rowBytes(size_t data_size) { return (blockCount(data_size) + 63) / 64 * 8; }
+  // bytes of the index file, the rows start at headerSize()
+  static size_t headerSize();
+  static size_t fileSize(size_t data_size) { return headerSize() + Rows * rowBytes(data_size); }
+  // header for an index of data_size bytes, stamp identifies the version of the data (e.g. its mtime)
+  static std::string header(size_t data_size, int64_t stamp);
+  // adds the trigrams starting in data[0, len) to the filter of a block, data has available bytes (len + 2
+  // unless at the end)
+  static void addBlock(const uint8_t* data, size_t len, size_t available, uint8_t* filter);
+  // writes the filters of count consecutive blocks from block (a multiple of 8) into the rows
+  static void storeBlocks(const uint8_t* filters, size_t count, size_t block, size_t row_bytes, uint8_t* rows);
+
+  // modification time of the file at path (ns), 0 if it can't be read
+  static int64_t stamp(const std::string& path);
+
+  BlockIndex() {}
+
+  // false if there's no index at path or it doesn't match the data
+  bool load(const std::string& path, size_t data_size, int64_t stamp);
+
+  size_t dataSize() const { return m_data_size; }
+  size_t blocks() const { return m_blocks; }
+  bool contains(size_t block, uint32_t hash) const {
+    return m_rows[hash * m_row_bytes + block / 8] & (1 << (block % 8));
+  }
+
+  // false if nothing with these trigrams (in the order they're in the match) and of that length can start in block
+  bool possible(size_t block, const std::vector<uint32_t>& hashes, size_t length) const;
+};
+
+// hashes of the trigrams of pattern which have no wildcard, in order
+std::vector<uint32_t> trigramHashes(const Pattern& pattern);
+
+}
@@ -0,0 +1,135 @@
+#include "foldersearch.hpp"
+#include <algorithm>
+#include <helpers/filesystem_wrappers.hpp>
+#include <io/mappedfile.hpp>
+
+const size_t search::FolderSearch::BlockSize;
+const size_t search::FolderSearch::MaxFileHits;
+
+bool search::FolderSearch::start(const std::string& folder, const std::string& extension,
+                                 std::shared_ptr<const Matcher> matcher) {
+  clear();
+  if(!matcher || !matcher->length())
+    return false;
+
+  auto job = std::unique_ptr<Job>(new Job);
+  io::iterateFiles(fs::path(folder), extension, [&job](fs::path path) {
+    job->files.push_back(path.string());
+  });
+  if(job->files.empty())
+    return false;
+  // the same order every time, whatever the directory gives
+  std::sort(job->files.begin(), job->files.end());
+  job->matcher = matcher;
+
+  m_matcher = matcher;
+  m_file_count = job->files.size();
+
+  const size_t threads = std::min((size_t)std::max(1u, std::thread::hardware_concurrency()), job->files.size());
+  job->running = (int)threads;
+
+  for(size_t i = 0; i < threads; i++)
+    m_threads.emplace_back(work, job.get());
+  m_job = std::move(job);
+  return true;
+}
+
+void search::FolderSearch::cancel() {
+  if(!m_job)
+    return;
+
+  // the workers notice within one block
+  m_job->cancel = true;
+  for(auto& thread : m_threads)
+    thread.join();
+  m_threads.clear();
+  collect();
+  m_job.reset();
+}
+
+void search::FolderSearch::clear() {
+  cancel();
+  m_matcher.reset();
+  m_results.clear();
+  m_hit_count = 0;
+  m_file_count = 0;
+  m_failed = 0;
+}
+
+bool search::FolderSearch::poll() {
+  if(!m_job)
+    return false;
+
+  // read before collecting, so nothing a worker published before it finished is missed
+  const bool finished = m_job->running == 0;
+  collect();
+
+  if(finished) {
+    for(auto& thread : m_threads)
+      thread.join();
+    m_threads.clear();
+    m_job.reset();
+  }
+  return finished;
+}
+
+void search::FolderSearch::collect() {
+  Job& job = *m_job;
+  std::lock_guard<std::mutex> lock(job.mutex);
+  for(auto& file : job.done) {
+    m_hit_count += file.hits.size();
+    m_results.push_back(std::move(file));
+  }
+  job.done.clear();
+  m_failed = job.failed;
+}
+
+float search::FolderSearch::progress() const {
+  if(!m_job)
+    return 1.0f;
+  return (float)((double)m_job->searched / (double)m_job->files.size());
+}
+
+void search::FolderSearch::work(Job* job) {
+  const size_t overlap = job->matcher->length() - 1;
+
+  while(!job->cancel) {
+    const size_t index = job->next_file++;
+    if(index >= job->files.size())
+      break;
+
+    FileHits file;
+    file.path = job->files[index];
+
+    io::MappedFile mapped;
+    if(!mapped.open(file.path)) {
+      job->failed++;
+      job->searched++;
+      continue;
+    }
+    mapped.advise(io::AccessHint_Sequential);
+    const uint8_t* data = mapped.data();
+    file.size = mapped.size();
+
+    for(size_t pos = 0; pos < file.size && !job->cancel; pos += BlockSize) {
+      // matches starting in this block, the overlap is only there to complete them
+      const size_t n = std::min(BlockSize, file.size - pos);
+      job->matcher->scan(data + pos, std::min(n + overlap, file.size - pos), n, pos, file.hits);
+      if(file.hits.size() > MaxFileHits) {
+        file.hits.resize(MaxFileHits);
+        file.truncated = true;
+        break;
+      }
+    }
+    if(job->cancel)
+      break;
+
+    job->searched++;
+    if(file.hits.empty())
+      continue;
+    std::lock_guard<std::mutex> lock(job->mutex);
+    job->done.push_back(std::move(file));
+  }
+
+  job->running--;
+}
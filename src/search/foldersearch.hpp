@@ -0,0 +1,94 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include "matcher.hpp"
+
+namespace search {
+
+// the hits in one file of a folder search
+struct FileHits {
+  std::string path;
+  size_t size = 0;
+  // sorted by offset
+  std::vector<Hit> hits;
+  // true if the file had more than FolderSearch::MaxFileHits hits
+  bool truncated = false;
+};
+
+/*
+ * searches every file with a given extension in a folder (not its subfolders) on a pool of worker threads.
+ *
+ * the workers take whole files one after another, map them and scan them in place, so the files are read by the
+ * kernel's readahead and never copied. files with hits are published by poll() in the order they're done.
+ * */
+class FolderSearch {
+private:
+  struct Job {
+    std::vector<std::string> files;
+    std::shared_ptr<const Matcher> matcher;
+
+    std::atomic<size_t> next_file{0};
+    std::atomic<size_t> searched{0};
+    std::atomic<size_t> failed{0};
+    std::atomic<bool> cancel{false};
+    std::atomic<int> running{0};
+
+    std::mutex mutex;
+    // files with hits which haven't been published yet
+    std::vector<FileHits> done;
+  };
+
+  std::unique_ptr<Job> m_job;
+  std::vector<std::thread> m_threads;
+
+  std::shared_ptr<const Matcher> m_matcher;
+  std::vector<FileHits> m_results;
+  size_t m_hit_count = 0;
+  size_t m_file_count = 0;
+  size_t m_failed = 0;
+
+  static void work(Job* job);
+  void collect();
+
+  FolderSearch(const FolderSearch&);
+  void operator=(const FolderSearch&);
+
+public:
+  // what a worker scans at once
+  static const size_t BlockSize = 256 * 1024;
+  // hits past that many in one file are dropped
+  static const size_t MaxFileHits = 10000;
+
+  FolderSearch() {}
+  ~FolderSearch() { cancel(); }
+
+  // searches the files in folder ending in extension (with the dot, empty for all files) for what matcher
+  // matches. a running search is cancelled and the old results are dropped. returns false if there's nothing to
+  // search
+  bool start(const std::string& folder, const std::string& extension, std::shared_ptr<const Matcher> matcher);
+  // stops the workers and waits for them, the results so far are kept
+  void cancel();
+  void clear();
+  // has to be called regularly (every frame), publishes new results. returns true once a search has run to its
+  // end
+  bool poll();
+
+  bool isRunning() const { return m_job != nullptr; }
+  // 0..1, by files
+  float progress() const;
+
+  const Matcher* matcher() const { return m_matcher.get(); }
+  // the files with hits, in the order they were done
+  const std::vector<FileHits>& results() const { return m_results; }
+  size_t hitCount() const { return m_hit_count; }
+  // files searched and files which couldn't be opened
+  size_t fileCount() const { return m_file_count; }
+  size_t failedCount() const { return m_failed; }
+};
+
+}
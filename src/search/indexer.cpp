@@ -0,0 +1,153 @@
+#include "indexer.hpp"
+#include <application/log.hpp>
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+const size_t search::Indexer::GroupBlocks;
+
+void search::Indexer::start(io::DataSource* source, const std::string& path, int64_t stamp) {
+  cancel();
+  if(!source)
+    return;
+
+  auto job = std::unique_ptr<Job>(new Job);
+  job->source = source;
+  job->size = source->size();
+  job->blocks = BlockIndex::blockCount(job->size);
+  job->path = path;
+  job->stamp = stamp;
+  if(!createFile(job.get()))
+    return;
+
+  const size_t groups = (job->blocks + GroupBlocks - 1) / GroupBlocks;
+  const size_t threads = std::min((size_t)std::max(1u, std::thread::hardware_concurrency()),
+                                  std::max((size_t)1, groups));
+  job->running = (int)threads;
+  for(size_t i = 0; i < threads; i++)
+    m_threads.emplace_back(work, job.get());
+
+  m_job = std::move(job);
+}
+
+bool search::Indexer::createFile(Job* job) {
+  job->temp_path = job->path + ".tmp";
+  job->content_size = BlockIndex::fileSize(job->size);
+  job->fd = ::open(job->temp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if(job->fd < 0) {
+    LOG_ERROR("couldn't create " + job->temp_path + ": " + strerror(errno))
+    return false;
+  }
+
+  // the space is allocated up front, a full disk would be a SIGBUS when the mapping is written
+  const int err = posix_fallocate(job->fd, 0, (off_t)job->content_size);
+  void* map = err ? MAP_FAILED : mmap(nullptr, job->content_size, PROT_READ | PROT_WRITE, MAP_SHARED, job->fd, 0);
+  if(map == MAP_FAILED) {
+    LOG_ERROR("couldn't create " + job->temp_path + ": " + strerror(err ? err : errno))
+    closeFile(job, false);
+    return false;
+  }
+
+  job->content = (uint8_t*)map;
+  const std::string header = BlockIndex::header(job->size, job->stamp);
+  memcpy(job->content, header.data(), header.size());
+  return true;
+}
+
+bool search::Indexer::closeFile(Job* job, bool keep) {
+  bool ok = true;
+  if(job->content)
+    munmap(job->content, job->content_size);
+  job->content = nullptr;
+  if(job->fd >= 0)
+    ::close(job->fd);
+  job->fd = -1;
+
+  if(keep && rename(job->temp_path.c_str(), job->path.c_str()) != 0) {
+    LOG_ERROR("couldn't write " + job->path + ": " + strerror(errno))
+    ok = false;
+  }
+  if(!keep || !ok)
+    unlink(job->temp_path.c_str());
+  return ok;
+}
+
+void search::Indexer::cancel() {
+  if(m_job)
+    m_job->cancel = true;
+  for(auto& thread : m_threads)
+    thread.join();
+  m_threads.clear();
+  m_job.reset();
+}
+
+std::shared_ptr<const search::BlockIndex> search::Indexer::poll() {
+  if(!m_job || !m_job->done)
+    return nullptr;
+
+  for(auto& thread : m_threads)
+    thread.join();
+  m_threads.clear();
+
+  auto index = m_job->index;
+  m_job.reset();
+  return index;
+}
+
+float search::Indexer::progress() const {
+  if(!m_job || !m_job->blocks)
+    return 0.0f;
+  return (float)((double)m_job->indexed / (double)m_job->blocks);
+}
+
+void search::Indexer::work(Job* job) {
+  const size_t group_size = GroupBlocks * BlockIndex::BlockSize;
+  // the trigrams starting in the last 2 bytes of a group end in the next one
+  std::vector<uint8_t> buf(group_size + 2);
+  // the filters of the group's blocks, they're transposed into the rows once they're all done
+  std::vector<uint8_t> filters(GroupBlocks * BlockIndex::FilterBytes);
+  uint8_t* rows = job->content + BlockIndex::headerSize();
+  const size_t row_bytes = BlockIndex::rowBytes(job->size);
+
+  while(!job->cancel) {
+    const size_t group = job->next_group++;
+    const size_t start = group * group_size;
+    if(start >= job->size)
+      break;
+
+    const size_t want = std::min(group_size + 2, job->size - start);
+    const size_t len = job->source->read(start, buf.data(), want);
+    const size_t first = group * GroupBlocks;
+    const size_t count = std::min(GroupBlocks, job->blocks - first);
+    std::fill(filters.begin(), filters.end(), 0);
+    for(size_t b = 0; b < count; b++) {
+      const size_t off = b * BlockIndex::BlockSize;
+      uint8_t* filter = &filters[b * BlockIndex::FilterBytes];
+      if(len < want && off + BlockIndex::BlockSize + 2 > len) {
+        // couldn't be read completely, it mustn't be skipped
+        memset(filter, 0xFF, BlockIndex::FilterBytes);
+        continue;
+      }
+      BlockIndex::addBlock(buf.data() + off, std::min(BlockIndex::BlockSize, len - off), len - off, filter);
+    }
+    // the groups cover whole bytes of the rows, so the workers don't write to the same ones
+    BlockIndex::storeBlocks(filters.data(), count, first, row_bytes, rows);
+    job->indexed += count;
+  }
+
+  if(--job->running == 0)
+    finish(job);
+}
+
+void search::Indexer::finish(Job* job) {
+  // a cancelled index isn't complete, it's thrown away
+  if(closeFile(job, !job->cancel) && !job->cancel) {
+    auto index = std::make_shared<BlockIndex>();
+    if(index->load(job->path, job->size, job->stamp))
+      job->index = index;
+  }
+  job->done = true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <io/datasource.hpp>
+#include "blockindex.hpp"
+
+namespace search {
+
+/*
+ * builds a BlockIndex on a pool of worker threads and saves it. the last worker to finish writes the file, so
+ * nothing big happens in poll().
+ *
+ * the index is built in a temporary file next to path, which is mapped writable and renamed into place once it's
+ * complete. the workers take groups of blocks one after another and write their filters straight into the rows in
+ * the mapping, the groups don't share bytes of the rows so nothing has to be locked. the index never has to fit
+ * into memory, the kernel writes the pages back as it needs to. the source is read
+ * directly, it has to support concurrent reads (see DataSource) and stay alive until the index is done or cancel()
+ * returned.
+ * */
+class Indexer {
+private:
+  struct Job {
+    io::DataSource* source = nullptr;
+    size_t size = 0;
+    size_t blocks = 0;
+    std::string path;
+    int64_t stamp = 0;
+    // the temporary file and its mapping, header and rows
+    std::string temp_path;
+    int fd = -1;
+    uint8_t* content = nullptr;
+    size_t content_size = 0;
+    // what the last worker made of it, NULL if it failed or was cancelled
+    std::shared_ptr<BlockIndex> index;
+
+    std::atomic<size_t> next_group{0};
+    std::atomic<size_t> indexed{0};
+    std::atomic<bool> cancel{false};
+    std::atomic<int> running{0};
+    // set once the index is renamed into place
+    std::atomic<bool> done{false};
+  };
+
+  std::unique_ptr<Job> m_job;
+  std::vector<std::thread> m_threads;
+
+  // creates and maps the temporary file with the header
+  static bool createFile(Job* job);
+  // unmaps the temporary file, renames it to the index path if keep is set or removes it
+  static bool closeFile(Job* job, bool keep);
+  static void work(Job* job);
+  static void finish(Job* job);
+
+  Indexer(const Indexer&);
+  void operator=(const Indexer&);
+
+public:
+  // blocks a worker takes at once
+  static const size_t GroupBlocks = 64;
+
+  Indexer() {}
+  ~Indexer() { cancel(); }
+
+  // indexes source and saves the index to path, stamp identifies the version of the data. a running build is
+  // cancelled first
+  void start(io::DataSource* source, const std::string& path, int64_t stamp);
+  // stops the workers and waits for them
+  void cancel();
+  // has to be called regularly, returns the index once (when it's done)
+  std::shared_ptr<const BlockIndex> poll();
+
+  bool isRunning() const { return m_job != nullptr; }
+  // 0..1
+  float progress() const;
+};
+
+}
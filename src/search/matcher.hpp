@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace search {
+
+class BlockIndex;
+
+struct Hit {
+  size_t offset;
+  uint32_t length;
+  // what matched, depends on the matcher (e.g. the index of a signature)
+  uint32_t tag;
+};
+
+/*
+ * what a search looks for.
+ *
+ * Search splits the data into blocks and calls scan() for each of them from several threads at once, so scan()
+ * mustn't modify the matcher. every block has length() - 1 bytes of the next block appended, so each match is
+ * found in the block it starts in.
+ * */
+class Matcher {
+public:
+  virtual ~Matcher() {}
+
+  // longest match in bytes
+  virtual size_t length() const = 0;
+
+  // appends every match starting in data[0, count) to hits, data has len bytes (count + length() - 1, less at the
+  // end of the data), base is the offset of data
+  virtual void scan(const uint8_t* data, size_t len, size_t count, size_t base, std::vector<Hit>& hits) const = 0;
+
+  // what a hit matched, for the results list
+  virtual const char* name(const Hit& hit) const { (void)hit; return ""; }
+
+  // true if the hits of a finished search should be added as views
+  virtual bool addsViews() const { return false; }
+
+  // true if the hits should be listed by tag (lowest first) instead of by offset
+  virtual bool ranked() const { return false; }
+
+  // false if the index shows that no match can start in the given block, the block isn't scanned then
+  virtual bool possible(const BlockIndex& index, size_t block) const { (void)index; (void)block; return true; }
+};
+
+}
@@ -0,0 +1,189 @@
+#include "numeric.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// candidates compared before the matches are collected
+static const size_t Block = 1024;
+
+const char* search::numberTypeName(NumberType type) {
+  static const char* names[NumberType_COUNT] = {"u8", "i8", "u16", "i16", "u32", "i32", "u64", "i64", "float",
+                                                "double"};
+  return names[type];
+}
+
+size_t search::numberTypeSize(NumberType type) {
+  static const size_t sizes[NumberType_COUNT] = {1, 1, 2, 2, 4, 4, 8, 8, 4, 8};
+  return sizes[type];
+}
+
+bool search::NumberMatcher::setup(const NumberQuery& query) {
+  m_query = query;
+  m_empty = true;
+  if(query.type < 0 || query.type >= NumberType_COUNT || !query.align || query.scale == 0 ||
+     std::isnan(query.value) || std::isnan(query.scale) || !(query.tolerance >= 0))
+    return false;
+
+  const size_t size = numberTypeSize(query.type);
+  if(size == 1)
+    m_query.endian = Endian_Little;
+  m_names[0] = std::string(numberTypeName(query.type)) + (size > 1 ? " LE" : "");
+  m_names[1] = std::string(numberTypeName(query.type)) + " BE";
+
+  long double lo = (query.value - query.tolerance) / query.scale;
+  long double hi = (query.value + query.tolerance) / query.scale;
+  if(lo > hi)
+    std::swap(lo, hi);
+
+  if(query.type == NumberType_F32) {
+    m_flo = (float)lo;
+    m_fhi = (float)hi;
+    m_empty = false;
+    return true;
+  }
+  if(query.type == NumberType_F64) {
+    m_flo = (double)lo;
+    m_fhi = (double)hi;
+    m_empty = false;
+    return true;
+  }
+
+  const int bits = (int)size * 8;
+  const bool is_signed = query.type == NumberType_I8 || query.type == NumberType_I16 ||
+                         query.type == NumberType_I32 || query.type == NumberType_I64;
+  const long double min = is_signed ? -std::ldexp(1.0L, bits - 1) : 0.0L;
+  const long double max = is_signed ? std::ldexp(1.0L, bits - 1) - 1 : std::ldexp(1.0L, bits) - 1;
+  lo = std::max(std::ceil(lo), min);
+  hi = std::min(std::floor(hi), max);
+  // no integer in the range, the query is fine but can't match anything
+  if(lo > hi)
+    return true;
+
+  // flipping the sign bit orders signed numbers like unsigned ones
+  m_flip = is_signed ? 1ull << (bits - 1) : 0;
+  const uint64_t mask = bits == 64 ? ~0ull : (1ull << bits) - 1;
+  auto key = [&](long double v) {
+    return ((is_signed ? (uint64_t)(int64_t)v : (uint64_t)v) ^ m_flip) & mask;
+  };
+  m_lo = key(lo);
+  m_span = key(hi) - m_lo;
+  m_empty = false;
+  return true;
+}
+
+static inline uint8_t byteSwap(uint8_t v) { return v; }
+static inline uint16_t byteSwap(uint16_t v) { return __builtin_bswap16(v); }
+static inline uint32_t byteSwap(uint32_t v) { return __builtin_bswap32(v); }
+static inline uint64_t byteSwap(uint64_t v) { return __builtin_bswap64(v); }
+
+template<typename U>
+struct IntegerTest {
+  U flip, lo, span;
+  bool operator()(U raw) const { return (U)((raw ^ flip) - lo) <= span; }
+};
+
+template<typename U, typename F>
+struct FloatTest {
+  F lo, hi;
+  bool operator()(U raw) const {
+    F x;
+    memcpy(&x, &raw, sizeof(x));
+    return (lo <= x) & (x <= hi);
+  }
+};
+
+// no branches in here, so the loop is vectorized (with a constant stride at least)
+template<typename U, bool Swap, typename Test>
+static inline void compare(const uint8_t* data, size_t n, size_t stride, const Test& test, uint8_t* found) {
+  for(size_t k = 0; k < n; k++) {
+    U raw;
+    memcpy(&raw, data + k * stride, sizeof(raw));
+    if(Swap)
+      raw = byteSwap(raw);
+    found[k] = test(raw);
+  }
+}
+
+template<typename U, bool Swap, typename Test>
+static void scanNumbers(const uint8_t* data, size_t len, size_t count, size_t base, size_t align,
+                        const Test& test, uint32_t tag, std::vector<search::Hit>& hits) {
+  if(len < sizeof(U))
+    return;
+  const size_t end = std::min(count, len - sizeof(U) + 1);
+
+  uint8_t found[Block + 8] = {};
+  for(size_t pos = (align - base % align) % align; pos < end; pos += Block * align) {
+    const size_t n = std::min(Block, (end - pos + align - 1) / align);
+    if(align == 1)
+      compare<U, Swap>(data + pos, n, 1, test, found);
+    else
+      compare<U, Swap>(data + pos, n, align, test, found);
+    memset(found + n, 0, 8);
+
+    // matches are rare, skip 8 flags at once
+    for(size_t k = 0; k < n; k += 8) {
+      uint64_t any;
+      memcpy(&any, found + k, sizeof(any));
+      if(!any)
+        continue;
+      for(size_t j = k; j < k + 8; j++)
+        if(found[j])
+          hits.push_back(search::Hit{base + pos + j * align, (uint32_t)sizeof(U), tag});
+    }
+  }
+}
+
+template<typename U, typename Test>
+static void scanEndians(const uint8_t* data, size_t len, size_t count, size_t base, size_t align,
+                        search::Endian endian, const Test& test, std::vector<search::Hit>& hits) {
+  const size_t first = hits.size();
+  if(endian != search::Endian_Big)
+    scanNumbers<U, false>(data, len, count, base, align, test, 0, hits);
+  const size_t middle = hits.size();
+  if(endian != search::Endian_Little)
+    scanNumbers<U, true>(data, len, count, base, align, test, 1, hits);
+
+  std::inplace_merge(hits.begin() + first, hits.begin() + middle, hits.end(),
+                     [](const search::Hit& a, const search::Hit& b) { return a.offset < b.offset; });
+}
+
+template<typename U>
+static IntegerTest<U> integerTest(uint64_t flip, uint64_t lo, uint64_t span) {
+  return IntegerTest<U>{(U)flip, (U)lo, (U)span};
+}
+
+void search::NumberMatcher::scan(const uint8_t* data, size_t len, size_t count, size_t base,
+                                 std::vector<Hit>& hits) const {
+  if(m_empty)
+    return;
+
+  const size_t align = m_query.align;
+  const Endian endian = m_query.endian;
+  switch(m_query.type) {
+  case NumberType_U8:
+  case NumberType_I8:
+    scanEndians<uint8_t>(data, len, count, base, align, endian, integerTest<uint8_t>(m_flip, m_lo, m_span), hits);
+    break;
+  case NumberType_U16:
+  case NumberType_I16:
+    scanEndians<uint16_t>(data, len, count, base, align, endian, integerTest<uint16_t>(m_flip, m_lo, m_span), hits);
+    break;
+  case NumberType_U32:
+  case NumberType_I32:
+    scanEndians<uint32_t>(data, len, count, base, align, endian, integerTest<uint32_t>(m_flip, m_lo, m_span), hits);
+    break;
+  case NumberType_U64:
+  case NumberType_I64:
+    scanEndians<uint64_t>(data, len, count, base, align, endian, integerTest<uint64_t>(m_flip, m_lo, m_span), hits);
+    break;
+  case NumberType_F32:
+    scanEndians<uint32_t>(data, len, count, base, align, endian,
+                          FloatTest<uint32_t, float>{(float)m_flo, (float)m_fhi}, hits);
+    break;
+  case NumberType_F64:
+    scanEndians<uint64_t>(data, len, count, base, align, endian, FloatTest<uint64_t, double>{m_flo, m_fhi}, hits);
+    break;
+  default:
+    break;
+  }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include "matcher.hpp"
+
+namespace search {
+
+enum NumberType {
+  NumberType_U8, NumberType_I8, NumberType_U16, NumberType_I16, NumberType_U32, NumberType_I32,
+  NumberType_U64, NumberType_I64, NumberType_F32, NumberType_F64, NumberType_COUNT
+};
+
+enum Endian { Endian_Little, Endian_Big, Endian_Both };
+
+const char* numberTypeName(NumberType type);
+size_t numberTypeSize(NumberType type);
+
+struct NumberQuery {
+  NumberType type = NumberType_U32;
+  Endian endian = Endian_Little;
+  // a stored number x matches if |x * scale - value| <= tolerance
+  long double value = 0;
+  long double tolerance = 0;
+  long double scale = 1;
+  // only offsets which are a multiple of align are looked at
+  size_t align = 1;
+};
+
+/*
+ * finds numbers of a given type which are within a range.
+ *
+ * the query is turned into bounds on the stored value first: integers are compared as unsigned after flipping
+ * the sign bit of signed types, so a range check is one subtraction and compare. floats are compared as they are
+ * (the bounds are rounded to the type, so "3.14159" finds the float nearest to it). the compare kernels work on
+ * blocks without branches, gcc vectorizes them, the few matches are collected from the flags afterwards.
+ *
+ * the tag of a hit is 0 for little endian matches, 1 for big endian ones.
+ * */
+class NumberMatcher : public Matcher {
+private:
+  NumberQuery m_query;
+  // bounds of the stored value, as bits for integers (in the sign flipped order)
+  uint64_t m_lo = 0, m_span = 0;
+  double m_flo = 0, m_fhi = 0;
+  uint64_t m_flip = 0;
+  bool m_empty = true;
+  std::string m_names[2];
+
+public:
+  // false if the query doesn't make sense (scale or align 0, negative tolerance)
+  bool setup(const NumberQuery& query);
+
+  size_t length() const override { return numberTypeSize(m_query.type); }
+  void scan(const uint8_t* data, size_t len, size_t count, size_t base, std::vector<Hit>& hits) const override;
+  const char* name(const Hit& hit) const override { return m_names[hit.tag].c_str(); }
+  bool addsViews() const override { return true; }
+};
+
+}
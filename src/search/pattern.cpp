@@ -0,0 +1,96 @@
+#include "pattern.hpp"
+#include <stdlib.h>
+
+static int nibble(char c) {
+  if(c >= '0' && c <= '9')
+    return c - '0';
+  if(c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  if(c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  return -1;
+}
+
+// rough guess how often a byte shows up in binaries, lower is rarer
+static int commonness(uint8_t b) {
+  if(b == 0x00 || b == 0xFF)
+    return 3;
+  if(b == ' ' || (b >= 'a' && b <= 'z') || b == 0x01 || b == 0x20 || b == 0xCC || b == 0x90)
+    return 2;
+  if(b >= 0x20 && b < 0x7F)
+    return 1;
+  return 0;
+}
+
+bool search::Pattern::parse(const std::string& text) {
+  m_value.clear();
+  m_mask.clear();
+
+  // nibbles are paired up in order, whitespace between the bytes is optional
+  int nibbles = 0;
+  uint8_t value = 0, mask = 0;
+  for(char c : text) {
+    if(c == ' ' || c == '\t' || c == ',')
+      continue;
+
+    value <<= 4;
+    mask <<= 4;
+    if(c == '?') {
+      // wildcard, nothing to compare
+    } else {
+      int n = nibble(c);
+      if(n < 0) {
+        m_value.clear();
+        m_mask.clear();
+        return false;
+      }
+      value |= (uint8_t)n;
+      mask |= 0xF;
+    }
+
+    if(++nibbles % 2 == 0) {
+      m_value.push_back(value);
+      m_mask.push_back(mask);
+      value = mask = 0;
+    }
+  }
+
+  if(nibbles % 2) {
+    m_value.clear();
+    m_mask.clear();
+    return false;
+  }
+
+  chooseAnchors();
+  return !m_value.empty();
+}
+
+void search::Pattern::assign(const uint8_t* bytes, size_t len) {
+  m_value.assign(bytes, bytes + len);
+  m_mask.assign(len, 0xFF);
+  chooseAnchors();
+}
+
+void search::Pattern::chooseAnchors() {
+  m_anchor[0] = m_anchor[1] = -1;
+
+  // the rarest fully specified byte, then the rarest one as far away from it as possible
+  for(size_t i = 0; i < m_value.size(); i++) {
+    if(m_mask[i] != 0xFF)
+      continue;
+    if(m_anchor[0] < 0 || commonness(m_value[i]) < commonness(m_value[m_anchor[0]]))
+      m_anchor[0] = (int)i;
+  }
+  if(m_anchor[0] < 0)
+    return;
+
+  m_anchor[1] = m_anchor[0];
+  for(size_t i = 0; i < m_value.size(); i++) {
+    if(m_mask[i] != 0xFF || (int)i == m_anchor[0])
+      continue;
+    if(m_anchor[1] == m_anchor[0] || commonness(m_value[i]) < commonness(m_value[m_anchor[1]]) ||
+       (commonness(m_value[i]) == commonness(m_value[m_anchor[1]]) &&
+        abs((int)i - m_anchor[0]) > abs(m_anchor[1] - m_anchor[0])))
+      m_anchor[1] = (int)i;
+  }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace search {
+
+/*
+ * byte pattern with wildcards, parsed from hex text like "4D 5A ?? ?? 5?".
+ *
+ * every nibble is either a hex digit or '?', a byte matches if (data & mask) == value. the two fully specified
+ * bytes which are least likely to be common (not 00/FF/...) are the anchors the scanner looks for first.
+ * */
+class Pattern {
+private:
+  std::vector<uint8_t> m_value;
+  std::vector<uint8_t> m_mask;
+  // positions of the anchor bytes, -1 if the pattern has no fully specified byte
+  int m_anchor[2] = {-1, -1};
+
+  void chooseAnchors();
+
+public:
+  // false if text isn't a valid pattern, the pattern is empty then
+  bool parse(const std::string& text);
+  // exact bytes, without wildcards
+  void assign(const uint8_t* bytes, size_t len);
+
+  bool empty() const { return m_value.empty(); }
+  size_t size() const { return m_value.size(); }
+  const uint8_t* value() const { return m_value.data(); }
+  const uint8_t* mask() const { return m_mask.data(); }
+  int anchor(int i) const { return m_anchor[i]; }
+
+  // data has to have at least size() bytes
+  bool matches(const uint8_t* data) const {
+    for(size_t i = 0; i < m_value.size(); i++)
+      if((data[i] & m_mask[i]) != m_value[i])
+        return false;
+    return true;
+  }
+};
+
+}
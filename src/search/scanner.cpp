@@ -0,0 +1,97 @@
+#include "scanner.hpp"
+#include "blockindex.hpp"
+#include <algorithm>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SEARCH_HAVE_AVX2 1
+#endif
+
+bool search::hasAvx2() {
+#ifdef SEARCH_HAVE_AVX2
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  return avx2;
+#else
+  return false;
+#endif
+}
+
+static void scanAll(const search::Pattern& pattern, const uint8_t* data, size_t count, size_t base,
+                    std::vector<search::Hit>& hits) {
+  for(size_t i = 0; i < count; i++)
+    if(pattern.matches(data + i))
+      hits.push_back(search::Hit{base + i, (uint32_t)pattern.size(), 0});
+}
+
+static void scanMemchr(const search::Pattern& pattern, const uint8_t* data, size_t count, size_t base,
+                       std::vector<search::Hit>& hits) {
+  const size_t a = (size_t)pattern.anchor(0);
+  const uint8_t value = pattern.value()[a];
+
+  const uint8_t* p = data + a;
+  const uint8_t* end = data + a + count;
+  while(p < end && (p = (const uint8_t*)memchr(p, value, (size_t)(end - p)))) {
+    const size_t pos = (size_t)(p - data) - a;
+    if(pattern.matches(data + pos))
+      hits.push_back(search::Hit{base + pos, (uint32_t)pattern.size(), 0});
+    p++;
+  }
+}
+
+#ifdef SEARCH_HAVE_AVX2
+__attribute__((target("avx2")))
+static void scanAvx2(const search::Pattern& pattern, const uint8_t* data, size_t count, size_t base,
+                     std::vector<search::Hit>& hits) {
+  const size_t a = (size_t)pattern.anchor(0), b = (size_t)pattern.anchor(1);
+  const __m256i first = _mm256_set1_epi8((char)pattern.value()[a]);
+  const __m256i second = _mm256_set1_epi8((char)pattern.value()[b]);
+
+  // both anchors have to be at the right distance, that leaves very few candidates to verify
+  size_t i = 0;
+  for(; i + 32 <= count; i += 32) {
+    const __m256i x = _mm256_loadu_si256((const __m256i*)(data + i + a));
+    const __m256i y = _mm256_loadu_si256((const __m256i*)(data + i + b));
+    uint32_t candidates = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(x, first),
+                                                                          _mm256_cmpeq_epi8(y, second)));
+    while(candidates) {
+      const size_t pos = i + (size_t)__builtin_ctz(candidates);
+      if(pattern.matches(data + pos))
+        hits.push_back(search::Hit{base + pos, (uint32_t)pattern.size(), 0});
+      candidates &= candidates - 1;
+    }
+  }
+
+  scanMemchr(pattern, data + i, count - i, base + i, hits);
+}
+#endif
+
+void search::scan(const Pattern& pattern, const uint8_t* data, size_t len, size_t base, std::vector<Hit>& hits) {
+  if(pattern.empty() || len < pattern.size())
+    return;
+
+  // number of positions a match can start at
+  const size_t count = len - pattern.size() + 1;
+
+  if(pattern.anchor(0) < 0)
+    return scanAll(pattern, data, count, base, hits);
+
+#ifdef SEARCH_HAVE_AVX2
+  if(hasAvx2())
+    return scanAvx2(pattern, data, count, base, hits);
+#endif
+  scanMemchr(pattern, data, count, base, hits);
+}
+
+search::PatternMatcher::PatternMatcher(const Pattern& pattern)
+  : m_pattern(pattern), m_trigrams(trigramHashes(pattern)) {
+}
+
+void search::PatternMatcher::scan(const uint8_t* data, size_t len, size_t count, size_t base,
+                                  std::vector<Hit>& hits) const {
+  search::scan(m_pattern, data, std::min(len, count + m_pattern.size() - 1), base, hits);
+}
+
+bool search::PatternMatcher::possible(const BlockIndex& index, size_t block) const {
+  return index.possible(block, m_trigrams, m_pattern.size());
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include "pattern.hpp"
+#include "matcher.hpp"
+
+namespace search {
+
+/*
+ * finds all matches of a pattern in a buffer.
+ *
+ * candidates are found with a prefilter on the two anchor bytes of the pattern and verified with the masked
+ * compare afterwards: 32 positions at once with AVX2 (if the cpu has it, checked at runtime), memchr() on the
+ * first anchor otherwise. patterns without a fully specified byte are compared at every position.
+ * */
+
+// appends base + position of every match starting in data[0, len - pattern.size()] to hits
+void scan(const Pattern& pattern, const uint8_t* data, size_t len, size_t base, std::vector<Hit>& hits);
+
+bool hasAvx2();
+
+class PatternMatcher : public Matcher {
+private:
+  Pattern m_pattern;
+  // for BlockIndex
+  std::vector<uint32_t> m_trigrams;
+
+public:
+  explicit PatternMatcher(const Pattern& pattern);
+
+  size_t length() const override { return m_pattern.size(); }
+  void scan(const uint8_t* data, size_t len, size_t count, size_t base, std::vector<Hit>& hits) const override;
+  bool possible(const BlockIndex& index, size_t block) const override;
+};
+
+}
@@ -0,0 +1,164 @@
+#include "search.hpp"
+#include <algorithm>
+
+const size_t search::Search::ChunkSize;
+const size_t search::Search::BlockSize;
+const size_t search::Search::MaxHits;
+
+void search::Search::start(std::unique_ptr<io::DataSource> source, std::shared_ptr<const Matcher> matcher,
+                           std::shared_ptr<const BlockIndex> index) {
+  cancel();
+
+  m_matcher = matcher;
+  m_hits.clear();
+  m_published = 0;
+  m_truncated = false;
+  m_running = false;
+  if(!source || !matcher || !matcher->length())
+    return;
+
+  auto job = std::unique_ptr<Job>(new Job);
+  job->size = source->size();
+  job->source = std::move(source);
+  job->matcher = matcher;
+  if(index && index->dataSize() == job->size)
+    job->index = index;
+  job->chunk_count = (job->size + ChunkSize - 1) / ChunkSize;
+
+  const size_t threads = std::min((size_t)std::max(1u, std::thread::hardware_concurrency()),
+                                  std::max((size_t)1, job->chunk_count));
+  job->running = (int)threads;
+
+  for(size_t i = 0; i < threads; i++)
+    m_current.threads.emplace_back(work, job.get());
+  m_current.job = std::move(job);
+  m_running = true;
+}
+
+void search::Search::cancel() {
+  if(!m_current.job)
+    return;
+
+  // the workers notice within one block, they're joined by poll() afterwards
+  m_current.job->cancel = true;
+  m_retired.push_back(std::move(m_current));
+  m_current = Workers();
+  m_running = false;
+}
+
+void search::Search::clear() {
+  cancel();
+  for(auto& workers : m_retired)
+    join(workers);
+  m_retired.clear();
+
+  m_matcher.reset();
+  m_hits.clear();
+  m_published = 0;
+  m_truncated = false;
+}
+
+void search::Search::join(Workers& workers) {
+  for(auto& thread : workers.threads)
+    thread.join();
+  workers.threads.clear();
+}
+
+bool search::Search::poll() {
+  // cancelled workers which are done can be joined without waiting
+  for(size_t i = 0; i < m_retired.size(); ) {
+    if(m_retired[i].job->running == 0) {
+      join(m_retired[i]);
+      m_retired.erase(m_retired.begin() + i);
+    } else {
+      i++;
+    }
+  }
+
+  if(!m_current.job)
+    return false;
+
+  // read before collecting, so nothing a worker published before it finished is missed
+  const bool finished = m_current.job->running == 0;
+  collect();
+
+  if(finished) {
+    m_truncated = m_current.job->found >= MaxHits;
+    join(m_current);
+    m_current = Workers();
+    m_running = false;
+  }
+  return finished;
+}
+
+void search::Search::collect() {
+  Job& job = *m_current.job;
+  std::lock_guard<std::mutex> lock(job.mutex);
+  for(auto it = job.done.begin(); it != job.done.end() && it->first == m_published; it = job.done.erase(it)) {
+    m_hits.insert(m_hits.end(), it->second.begin(), it->second.end());
+    m_published++;
+  }
+}
+
+float search::Search::progress() const {
+  if(!m_current.job)
+    return m_running ? 0.0f : 1.0f;
+  const Job& job = *m_current.job;
+  return job.size ? (float)((double)job.scanned / (double)job.size) : 1.0f;
+}
+
+void search::Search::work(Job* job) {
+  const size_t overlap = job->matcher->length() - 1;
+  std::vector<uint8_t> buf(BlockSize + overlap);
+
+  while(!job->cancel && job->found < MaxHits) {
+    const size_t chunk = job->next_chunk++;
+    if(chunk >= job->chunk_count)
+      break;
+
+    const size_t start = chunk * ChunkSize;
+    const size_t end = std::min(start + ChunkSize, job->size);
+
+    // the runs of index blocks which can have matches, all of the chunk without an index
+    std::vector<std::pair<size_t, size_t>> runs;
+    if(job->index) {
+      for(size_t pos = start; pos < end; pos += BlockIndex::BlockSize) {
+        const size_t block_end = std::min(pos + BlockIndex::BlockSize, end);
+        if(!job->matcher->possible(*job->index, pos / BlockIndex::BlockSize))
+          job->scanned += block_end - pos;
+        else if(!runs.empty() && runs.back().second == pos)
+          runs.back().second = block_end;
+        else
+          runs.emplace_back(pos, block_end);
+      }
+    } else {
+      runs.emplace_back(start, end);
+    }
+
+    std::vector<Hit> hits;
+    for(auto& run : runs) {
+      job->source->prefetch(run.first, run.second - run.first + overlap);
+      size_t pos = run.first;
+      while(pos < run.second && !job->cancel) {
+        // matches starting in this block, the overlap is only read to complete them
+        const size_t want = std::min(BlockSize + overlap, job->size - pos);
+        const size_t len = job->source->read(pos, buf.data(), want);
+        const size_t n = std::min(BlockSize, run.second - pos);
+        job->matcher->scan(buf.data(), std::min(len, n + overlap), n, pos, hits);
+
+        job->scanned += n;
+        pos += n;
+        if(len < want)
+          break;
+      }
+    }
+    if(job->cancel)
+      break;
+
+    job->found += hits.size();
+    std::lock_guard<std::mutex> lock(job->mutex);
+    job->done[chunk] = std::move(hits);
+  }
+
+  job->running--;
+}
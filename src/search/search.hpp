@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <io/datasource.hpp>
+#include "matcher.hpp"
+#include "blockindex.hpp"
+
+namespace search {
+
+/*
+ * searches a data source on a pool of worker threads, the matcher decides what's searched for.
+ *
+ * the data is split into chunks the workers take one after another. a worker reads its chunk in pieces that fit
+ * into the L2 cache, the pieces overlap by the longest match - 1 so matches across borders are found exactly once.
+ * the hits of every chunk are kept until all chunks before it are done, poll() moves them over in offset order, so
+ * hits() is always sorted and complete up to progress().
+ *
+ * with a BlockIndex of the data the blocks the matcher rules out aren't read at all.
+ *
+ * nothing blocks the ui: cancel() only tells the workers to stop (they're joined in a later poll() once they
+ * noticed), starting a new search cancels the running one. clear() waits for all workers, it has to be called
+ * before anything the source depends on goes away.
+ * */
+class Search {
+private:
+  // state shared with the workers, cancelled searches keep it alive until their workers are done
+  struct Job {
+    std::unique_ptr<io::DataSource> source;
+    std::shared_ptr<const Matcher> matcher;
+    std::shared_ptr<const BlockIndex> index;
+    size_t size = 0;
+    size_t chunk_count = 0;
+
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<size_t> scanned{0};
+    std::atomic<size_t> found{0};
+    std::atomic<bool> cancel{false};
+    std::atomic<int> running{0};
+
+    std::mutex mutex;
+    // hits of finished chunks which can't be published yet
+    std::map<size_t, std::vector<Hit>> done;
+  };
+
+  struct Workers {
+    std::unique_ptr<Job> job;
+    std::vector<std::thread> threads;
+  };
+
+  Workers m_current;
+  std::vector<Workers> m_retired;
+
+  std::shared_ptr<const Matcher> m_matcher;
+  std::vector<Hit> m_hits;
+  size_t m_published = 0;
+  bool m_running = false;
+  bool m_truncated = false;
+
+  static void work(Job* job);
+  // takes the hits of the chunks which are next in order
+  void collect();
+  void join(Workers& workers);
+
+  Search(const Search&);
+  void operator=(const Search&);
+
+public:
+  static const size_t ChunkSize = 4 * 1024 * 1024;
+  // what a worker scans at once
+  static const size_t BlockSize = 256 * 1024;
+  // the search stops once that many hits were found
+  static const size_t MaxHits = 1000000;
+
+  Search() {}
+  ~Search() { clear(); }
+
+  // searches source (which is owned from now on) for what matcher matches, a running search is cancelled. the
+  // index is only used if it's of data of the same size, it has to be of the same data
+  void start(std::unique_ptr<io::DataSource> source, std::shared_ptr<const Matcher> matcher,
+             std::shared_ptr<const BlockIndex> index = nullptr);
+  // stops searching, the hits found so far are kept
+  void cancel();
+  // stops searching, waits for the workers and forgets the hits
+  void clear();
+  // has to be called regularly (every frame), publishes new hits and cleans up finished workers. returns true
+  // once a search has run to its end (not when it was cancelled)
+  bool poll();
+
+  bool isRunning() const { return m_running; }
+  // 0..1
+  float progress() const;
+  // true if the search stopped at MaxHits
+  bool truncated() const { return m_truncated; }
+
+  // the matcher of the last search, NULL if there was none
+  const Matcher* matcher() const { return m_matcher.get(); }
+  // sorted by offset
+  const std::vector<Hit>& hits() const { return m_hits; }
+};
+
+}
@@ -0,0 +1,175 @@
+#include "signatures.hpp"
+#include "blockindex.hpp"
+#include <application/log.hpp>
+#include <algorithm>
+#include <fstream>
+#include <deque>
+
+static const uint32_t NoState = 0xFFFFFFFF;
+
+static std::string trim(const std::string& s) {
+  const size_t begin = s.find_first_not_of(" \t\r");
+  if(begin == std::string::npos)
+    return "";
+  return s.substr(begin, s.find_last_not_of(" \t\r") - begin + 1);
+}
+
+bool search::SignatureSet::load(const std::string& path) {
+  clear();
+
+  std::ifstream file(path);
+  if(!file) {
+    LOG_ERROR("couldn't open " + path)
+    return false;
+  }
+
+  std::string line;
+  for(size_t number = 1; std::getline(file, line); number++) {
+    line = trim(line.substr(0, line.find('#')));
+    if(line.empty())
+      continue;
+
+    const size_t eq = line.find('=');
+    Pattern pattern;
+    if(eq == std::string::npos || !pattern.parse(line.substr(eq + 1))) {
+      LOG_WARN(path + ":" + std::to_string(number) + ": expected name = hex pattern")
+      continue;
+    }
+    if(!add(trim(line.substr(0, eq)), pattern))
+      LOG_WARN(path + ":" + std::to_string(number) + ": the pattern needs at least one byte without wildcards")
+  }
+
+  if(m_signatures.empty()) {
+    LOG_ERROR("no signatures in " + path)
+    return false;
+  }
+
+  build();
+  return true;
+}
+
+bool search::SignatureSet::add(const std::string& name, const Pattern& pattern) {
+  Signature signature{name, pattern, 0, 0, trigramHashes(pattern)};
+
+  // the automaton only matches exact bytes, so the longest exact run of the pattern is looked for
+  for(size_t i = 0; i < pattern.size(); ) {
+    size_t n = 0;
+    while(i + n < pattern.size() && pattern.mask()[i + n] == 0xFF)
+      n++;
+    if(n > signature.anchor_len) {
+      signature.anchor_off = i;
+      signature.anchor_len = n;
+    }
+    i += n + 1;
+  }
+  if(!signature.anchor_len)
+    return false;
+
+  m_signatures.push_back(signature);
+  m_length = std::max(m_length, pattern.size());
+  return true;
+}
+
+void search::SignatureSet::clear() {
+  m_signatures.clear();
+  m_length = 0;
+  m_next.clear();
+  m_out_start.clear();
+  m_out.clear();
+}
+
+void search::SignatureSet::build() {
+  // trie of the anchors
+  m_next.assign(256, NoState);
+  std::vector<std::vector<uint32_t>> out(1);
+  for(uint32_t id = 0; id < m_signatures.size(); id++) {
+    const Signature& signature = m_signatures[id];
+    uint32_t state = 0;
+    for(size_t i = 0; i < signature.anchor_len; i++) {
+      const uint8_t b = signature.pattern.value()[signature.anchor_off + i];
+      if(m_next[state * 256 + b] == NoState) {
+        m_next[state * 256 + b] = (uint32_t)out.size();
+        m_next.resize(m_next.size() + 256, NoState);
+        out.emplace_back();
+      }
+      state = m_next[state * 256 + b];
+    }
+    out[state].push_back(id);
+  }
+
+  // breadth first, so the failure state of every state is done before it. missing transitions are replaced by
+  // the ones of the failure state and the outputs of the failure state are added to the own ones
+  std::vector<uint32_t> fail(out.size(), 0);
+  std::deque<uint32_t> queue;
+  for(int c = 0; c < 256; c++) {
+    uint32_t& next = m_next[c];
+    if(next == NoState) {
+      next = 0;
+    } else {
+      fail[next] = 0;
+      queue.push_back(next);
+    }
+  }
+  while(!queue.empty()) {
+    const uint32_t state = queue.front();
+    queue.pop_front();
+
+    const std::vector<uint32_t>& inherited = out[fail[state]];
+    out[state].insert(out[state].end(), inherited.begin(), inherited.end());
+
+    for(int c = 0; c < 256; c++) {
+      uint32_t& next = m_next[state * 256 + c];
+      const uint32_t fallback = m_next[fail[state] * 256 + c];
+      if(next == NoState) {
+        next = fallback;
+      } else {
+        fail[next] = fallback;
+        queue.push_back(next);
+      }
+    }
+  }
+
+  m_out_start.assign(1, 0);
+  for(auto& ids : out) {
+    m_out.insert(m_out.end(), ids.begin(), ids.end());
+    m_out_start.push_back((uint32_t)m_out.size());
+  }
+}
+
+void search::SignatureSet::scan(const uint8_t* data, size_t len, size_t count, size_t base,
+                                std::vector<Hit>& hits) const {
+  const uint32_t* next = m_next.data();
+  const uint32_t* out_start = m_out_start.data();
+
+  const size_t first = hits.size();
+  uint32_t state = 0;
+  for(size_t i = 0; i < len; i++) {
+    state = next[state * 256 + data[i]];
+    if(out_start[state] == out_start[state + 1])
+      continue;
+
+    // an anchor ends at i, check the rest of the pattern around it
+    for(uint32_t o = out_start[state]; o < out_start[state + 1]; o++) {
+      const Signature& signature = m_signatures[m_out[o]];
+      const size_t anchor_start = i + 1 - signature.anchor_len;
+      if(anchor_start < signature.anchor_off)
+        continue;
+      const size_t start = anchor_start - signature.anchor_off;
+      if(start >= count || start + signature.pattern.size() > len || !signature.pattern.matches(data + start))
+        continue;
+      hits.push_back(Hit{base + start, (uint32_t)signature.pattern.size(), m_out[o]});
+    }
+  }
+
+  // they were found in the order their anchors end
+  std::sort(hits.begin() + first, hits.end(), [](const Hit& a, const Hit& b) {
+    return a.offset < b.offset || (a.offset == b.offset && a.tag < b.tag);
+  });
+}
+
+bool search::SignatureSet::possible(const BlockIndex& index, size_t block) const {
+  for(auto& signature : m_signatures)
+    if(index.possible(block, signature.trigrams, signature.pattern.size()))
+      return true;
+  return false;
+}
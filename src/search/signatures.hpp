@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "matcher.hpp"
+#include "pattern.hpp"
+
+namespace search {
+
+struct Signature {
+  std::string name;
+  Pattern pattern;
+  // longest run of fully specified bytes, it's what the automaton looks for
+  size_t anchor_off;
+  size_t anchor_len;
+  // for BlockIndex
+  std::vector<uint32_t> trigrams;
+};
+
+/*
+ * set of named byte patterns which are all searched in one pass.
+ *
+ * the anchors of all signatures are compiled into one Aho-Corasick automaton with a dense transition table (the
+ * failure links are resolved at build time), so scanning costs one table lookup per byte no matter how many
+ * signatures there are. a state which ends an anchor verifies the whole (wildcard) pattern around it.
+ *
+ * signature files have one signature per line, "name = hex pattern" (see Pattern), # starts a comment.
+ * */
+class SignatureSet : public Matcher {
+private:
+  std::vector<Signature> m_signatures;
+  size_t m_length = 0;
+
+  // 256 transitions per state, state 0 is the root
+  std::vector<uint32_t> m_next;
+  // signatures whose anchor ends in a state: m_out[m_out_start[s] .. m_out_start[s + 1])
+  std::vector<uint32_t> m_out_start;
+  std::vector<uint32_t> m_out;
+
+  void build();
+
+public:
+  // false if the file can't be read or has no valid signature, errors are logged with their line
+  bool load(const std::string& path);
+  // signatures need at least one fully specified byte
+  bool add(const std::string& name, const Pattern& pattern);
+  void clear();
+
+  const std::vector<Signature>& signatures() const { return m_signatures; }
+  size_t states() const { return m_out_start.empty() ? 0 : m_out_start.size() - 1; }
+
+  size_t length() const override { return m_length; }
+  void scan(const uint8_t* data, size_t len, size_t count, size_t base, std::vector<Hit>& hits) const override;
+  const char* name(const Hit& hit) const override { return m_signatures[hit.tag].name.c_str(); }
+  bool addsViews() const override { return true; }
+  bool possible(const BlockIndex& index, size_t block) const override;
+};
+
+}
@@ -0,0 +1,454 @@
+#include "strings.hpp"
+#include <algorithm>
+#include <string.h>
+
+const size_t search::StringList::MaxText;
+const size_t search::StringExtractor::ChunkSize;
+const size_t search::StringExtractor::MaxStrings;
+
+// bytes read before a chunk, to tell whether a string continues into it
+static const size_t Lookback = 4;
+// what's read at once when a string runs past the data at hand
+static const size_t ReadAhead = 64 * 1024;
+
+const char* search::stringEncodingName(int encoding) {
+  switch(encoding) {
+    case StringEncoding_Ascii: return "ascii";
+    case StringEncoding_Utf8: return "utf-8";
+    case StringEncoding_Utf16LE: return "utf-16le";
+    case StringEncoding_Utf16BE: return "utf-16be";
+  }
+  return "";
+}
+
+static bool isPrintable(uint32_t c) {
+  return (c >= 0x20 && c < 0x7f) || c == '\t';
+}
+
+static bool isPrintableLatin1(uint32_t c) {
+  return isPrintable(c) || (c >= 0xa0 && c < 0x100);
+}
+
+// length of the utf-8 sequence at p (with n bytes available) if it's a printable character, 0 otherwise
+static size_t utf8Char(const uint8_t* p, size_t n, uint32_t* code = nullptr) {
+  const uint8_t c = p[0];
+  if(c < 0x80) {
+    if(code)
+      *code = c;
+    return isPrintable(c) ? 1 : 0;
+  }
+
+  size_t len;
+  uint32_t cp, min;
+  if((c & 0xe0) == 0xc0) {
+    len = 2; cp = c & 0x1f; min = 0x80;
+  } else if((c & 0xf0) == 0xe0) {
+    len = 3; cp = c & 0x0f; min = 0x800;
+  } else if((c & 0xf8) == 0xf0) {
+    len = 4; cp = c & 0x07; min = 0x10000;
+  } else {
+    return 0;
+  }
+  if(n < len)
+    return 0;
+  for(size_t i = 1; i < len; i++) {
+    if((p[i] & 0xc0) != 0x80)
+      return 0;
+    cp = (cp << 6) | (p[i] & 0x3f);
+  }
+  // overlong, surrogates, out of range and the c1 controls
+  if(cp < min || (cp >= 0xd800 && cp < 0xe000) || cp > 0x10ffff || cp < 0xa0)
+    return 0;
+  if(code)
+    *code = cp;
+  return len;
+}
+
+static void appendUtf8(uint32_t cp, std::string& out) {
+  if(cp < 0x80) {
+    out += (char)cp;
+  } else if(cp < 0x800) {
+    out += (char)(0xc0 | (cp >> 6));
+    out += (char)(0x80 | (cp & 0x3f));
+  } else if(cp < 0x10000) {
+    out += (char)(0xe0 | (cp >> 12));
+    out += (char)(0x80 | ((cp >> 6) & 0x3f));
+    out += (char)(0x80 | (cp & 0x3f));
+  } else {
+    out += (char)(0xf0 | (cp >> 18));
+    out += (char)(0x80 | ((cp >> 12) & 0x3f));
+    out += (char)(0x80 | ((cp >> 6) & 0x3f));
+    out += (char)(0x80 | (cp & 0x3f));
+  }
+}
+
+void search::decodeString(const uint8_t* data, size_t len, int encoding, std::string& out) {
+  size_t i = 0;
+  while(i < len) {
+    uint32_t cp;
+    size_t n;
+    if(encoding == StringEncoding_Utf16LE || encoding == StringEncoding_Utf16BE) {
+      if(len - i < 2)
+        break;
+      cp = encoding == StringEncoding_Utf16LE ? data[i] | (data[i + 1] << 8) : (data[i] << 8) | data[i + 1];
+      n = 2;
+    } else {
+      n = utf8Char(data + i, len - i, &cp);
+      if(!n && data[i] >= 0xc0 && len - i < 4)
+        break;
+      // bytes which aren't part of a string, only if the range is off
+      if(!n) {
+        cp = '.';
+        n = 1;
+      }
+    }
+    // a tab wouldn't fit into a list row
+    appendUtf8(cp == '\t' ? ' ' : cp, out);
+    i += n;
+  }
+}
+
+void search::StringList::clear() {
+  offsets.clear();
+  lengths.clear();
+  encodings.clear();
+  text.clear();
+}
+
+void search::StringExtractor::start(std::unique_ptr<io::DataSource> source, unsigned encodings, size_t min_chars) {
+  cancel();
+
+  m_strings.clear();
+  m_published = 0;
+  m_truncated = false;
+  if(!source || !encodings)
+    return;
+
+  auto job = std::unique_ptr<Job>(new Job);
+  job->size = source->size();
+  job->source = std::move(source);
+  job->encodings = encodings;
+  job->min_chars = std::max((size_t)1, min_chars);
+  job->chunk_count = (job->size + ChunkSize - 1) / ChunkSize;
+
+  const size_t threads = std::min((size_t)std::max(1u, std::thread::hardware_concurrency()),
+                                  std::max((size_t)1, job->chunk_count));
+  job->running = (int)threads;
+
+  for(size_t i = 0; i < threads; i++)
+    m_threads.emplace_back(work, job.get());
+  m_job = std::move(job);
+}
+
+void search::StringExtractor::cancel() {
+  if(!m_job)
+    return;
+
+  m_job->cancel = true;
+  for(auto& thread : m_threads)
+    thread.join();
+  m_threads.clear();
+  // what's complete is kept
+  collect();
+  m_job.reset();
+}
+
+void search::StringExtractor::clear() {
+  cancel();
+  m_strings.clear();
+  m_published = 0;
+  m_truncated = false;
+}
+
+bool search::StringExtractor::poll() {
+  if(!m_job)
+    return false;
+
+  // read before collecting, so nothing a worker published before it finished is missed
+  const bool finished = m_job->running == 0;
+  collect();
+
+  if(finished) {
+    m_truncated = m_job->found >= MaxStrings;
+    for(auto& thread : m_threads)
+      thread.join();
+    m_threads.clear();
+    m_job.reset();
+  }
+  return finished;
+}
+
+void search::StringExtractor::collect() {
+  Job& job = *m_job;
+  std::lock_guard<std::mutex> lock(job.mutex);
+  for(auto it = job.done.begin(); it != job.done.end() && it->first == m_published; it = job.done.erase(it)) {
+    const StringList& list = it->second;
+    m_strings.offsets.insert(m_strings.offsets.end(), list.offsets.begin(), list.offsets.end());
+    m_strings.lengths.insert(m_strings.lengths.end(), list.lengths.begin(), list.lengths.end());
+    m_strings.encodings.insert(m_strings.encodings.end(), list.encodings.begin(), list.encodings.end());
+    m_strings.text += list.text;
+    m_published++;
+  }
+}
+
+float search::StringExtractor::progress() const {
+  if(!m_job)
+    return 1.0f;
+  return m_job->size ? (float)((double)m_job->scanned / (double)m_job->size) : 1.0f;
+}
+
+namespace {
+
+// the data of one chunk, read further on demand when a string goes on past it
+struct ChunkData {
+  io::DataSource* source;
+  size_t size;
+  // offset of buf[0]
+  size_t base;
+  std::vector<uint8_t> buf;
+
+  // set once a read came back short, the data ends there
+  bool short_read = false;
+
+  // true if the byte at off is there, reads it if it's still missing
+  bool has(size_t off) {
+    if(off - base < buf.size())
+      return true;
+    if(off >= size || short_read)
+      return false;
+    const size_t have = buf.size();
+    const size_t want = std::min(std::max(off + 1 - base - have, ReadAhead), size - base - have);
+    buf.resize(have + want);
+    const size_t got = source->read(base + have, buf.data() + have, want);
+    buf.resize(have + got);
+    short_read = got < want;
+    return off - base < buf.size();
+  }
+
+  const uint8_t* at(size_t off) const { return buf.data() + (off - base); }
+};
+
+struct Run {
+  size_t offset;
+  size_t length;
+  int encoding;
+};
+
+// length of the printable character at off, 0 if there's none
+template<int Encoding>
+inline size_t charAt(ChunkData& d, size_t off) {
+  if(Encoding == search::StringEncoding_Ascii) {
+    return d.has(off) && isPrintable(*d.at(off)) ? 1 : 0;
+  } else if(Encoding == search::StringEncoding_Utf8) {
+    if(!d.has(off))
+      return 0;
+    const uint8_t c = *d.at(off);
+    if(c < 0x80)
+      return isPrintable(c) ? 1 : 0;
+    // a sequence is at most 4 bytes, the ones at the end of the data are checked by utf8Char
+    d.has(off + 3);
+    return utf8Char(d.at(off), std::min((size_t)4, d.base + d.buf.size() - off));
+  } else {
+    if(!d.has(off + 1))
+      return 0;
+    const uint8_t* p = d.at(off);
+    const uint32_t unit = Encoding == search::StringEncoding_Utf16LE ? p[0] | (p[1] << 8) : (p[0] << 8) | p[1];
+    return isPrintableLatin1(unit) ? 2 : 0;
+  }
+}
+
+// false if the byte (utf-16 unit) at off can't be part of a printable character
+template<int Encoding>
+inline bool possible(ChunkData& d, size_t off) {
+  if(Encoding == search::StringEncoding_Utf8)
+    return d.has(off) && (*d.at(off) >= 0x80 || isPrintable(*d.at(off)));
+  return charAt<Encoding>(d, off) != 0;
+}
+
+// finds the strings starting in [from, end) at step aligned positions. a string which continues into from from
+// before belongs to the chunk before
+template<int Encoding>
+void findRuns(ChunkData& d, size_t from, size_t end, size_t step, size_t min_chars, bool continued,
+              bool want_ascii, const std::atomic<bool>& cancel, std::vector<Run>& runs) {
+  size_t pos = from;
+  if(continued) {
+    while(pos < end) {
+      const size_t n = charAt<Encoding>(d, pos);
+      if(!n)
+        break;
+      pos += n;
+    }
+  }
+
+  // a string of min_chars covers the byte (unit) min_chars - 1 steps ahead, if that can't be part of one nothing
+  // starts before it. this skips most of the data without looking at every byte. [pos, known) are bytes which
+  // were found to be possible already, so none is looked at twice going back
+  const size_t ahead = (min_chars - 1) * step;
+  size_t known = 0;
+  while(pos < end && !cancel) {
+    const size_t probe = pos + ahead;
+    if(!possible<Encoding>(d, probe)) {
+      pos = probe + step;
+      continue;
+    }
+    size_t first = probe;
+    while(first > pos && first - step >= known && possible<Encoding>(d, first - step))
+      first -= step;
+    if(first > pos && first - step < known)
+      first = pos;
+    known = probe + step;
+    pos = first;
+    if(pos >= end)
+      break;
+
+    size_t n = charAt<Encoding>(d, pos);
+    if(!n) {
+      pos += step;
+      continue;
+    }
+
+    const size_t start = pos;
+    size_t chars = 0;
+    bool ascii = true;
+    do {
+      ascii &= n == 1;
+      chars++;
+      pos += n;
+    } while((n = charAt<Encoding>(d, pos)));
+
+    if(chars < min_chars)
+      continue;
+    int encoding = Encoding;
+    if(Encoding == search::StringEncoding_Utf8 && ascii) {
+      if(!want_ascii)
+        continue;
+      encoding = search::StringEncoding_Ascii;
+    }
+    runs.push_back(Run{start, pos - start, encoding});
+  }
+}
+
+inline bool isContinuation(uint8_t c) {
+  return (c & 0xc0) == 0x80;
+}
+
+}
+
+void search::StringExtractor::work(Job* job) {
+  const bool ascii = job->encodings & (1 << StringEncoding_Ascii);
+  const bool utf8 = job->encodings & (1 << StringEncoding_Utf8);
+
+  while(!job->cancel && job->found < MaxStrings) {
+    const size_t chunk = job->next_chunk++;
+    if(chunk >= job->chunk_count)
+      break;
+
+    const size_t begin = chunk * ChunkSize;
+    const size_t end = std::min(begin + ChunkSize, job->size);
+
+    ChunkData d;
+    d.source = job->source.get();
+    d.size = job->size;
+    d.base = begin - std::min(begin, Lookback);
+    d.buf.resize(end - d.base);
+    const size_t len = d.source->read(d.base, d.buf.data(), d.buf.size());
+    d.short_read = len < d.buf.size();
+    d.buf.resize(len);
+
+    std::vector<Run> runs;
+    if(utf8) {
+      // characters never start on a continuation byte, and the last one before from ends at most 4 bytes back
+      size_t from = begin;
+      while(from < end && d.has(from) && isContinuation(*d.at(from)))
+        from++;
+      size_t last = from;
+      while(last > d.base && from - last < 3 && isContinuation(*d.at(last - 1)))
+        last--;
+      const bool continued = last > d.base &&
+                             charAt<StringEncoding_Utf8>(d, last - 1) == from - (last - 1);
+      findRuns<StringEncoding_Utf8>(d, from, end, 1, job->min_chars, continued, ascii, job->cancel, runs);
+    } else if(ascii) {
+      const bool continued = begin > 0 && charAt<StringEncoding_Ascii>(d, begin - 1);
+      findRuns<StringEncoding_Ascii>(d, begin, end, 1, job->min_chars, continued, true, job->cancel, runs);
+    }
+    // chunks start at even offsets, so both parities line up with the chunk before
+    for(size_t parity = 0; parity < 2; parity++) {
+      const size_t from = begin + parity;
+      if(job->encodings & (1 << StringEncoding_Utf16LE)) {
+        const bool continued = from >= 2 && charAt<StringEncoding_Utf16LE>(d, from - 2);
+        findRuns<StringEncoding_Utf16LE>(d, from, end, 2, job->min_chars, continued, false, job->cancel, runs);
+      }
+      if(job->encodings & (1 << StringEncoding_Utf16BE)) {
+        const bool continued = from >= 2 && charAt<StringEncoding_Utf16BE>(d, from - 2);
+        findRuns<StringEncoding_Utf16BE>(d, from, end, 2, job->min_chars, continued, false, job->cancel, runs);
+      }
+    }
+    if(job->cancel)
+      break;
+
+    std::sort(runs.begin(), runs.end(), [](const Run& a, const Run& b) {
+      return a.offset < b.offset || (a.offset == b.offset && a.encoding < b.encoding);
+    });
+
+    StringList list;
+    list.offsets.reserve(runs.size());
+    list.lengths.reserve(runs.size());
+    list.encodings.reserve(runs.size());
+    for(const Run& run : runs) {
+      list.offsets.push_back(run.offset);
+      list.lengths.push_back((uint32_t)std::min(run.length, (size_t)UINT32_MAX));
+      list.encodings.push_back((uint8_t)run.encoding);
+
+      // the filter only looks at the start, an incomplete character there is dropped by decodeString
+      const size_t text_start = list.text.size();
+      decodeString(d.at(run.offset), std::min(run.length, StringList::MaxText), run.encoding, list.text);
+      for(size_t i = text_start; i < list.text.size(); i++) {
+        if(list.text[i] >= 'A' && list.text[i] <= 'Z')
+          list.text[i] += 'a' - 'A';
+      }
+      list.text += '\0';
+    }
+
+    job->scanned += end - begin;
+    job->found += runs.size();
+    std::lock_guard<std::mutex> lock(job->mutex);
+    job->done[chunk] = std::move(list);
+  }
+
+  job->running--;
+}
+
+void search::StringFilter::setNeedle(const std::string& needle) {
+  std::string lower = needle;
+  for(char& c : lower) {
+    if(c >= 'A' && c <= 'Z')
+      c += 'a' - 'A';
+  }
+  if(lower == m_needle)
+    return;
+  m_needle = lower;
+  reset();
+}
+
+void search::StringFilter::reset() {
+  m_matches.clear();
+  m_next = 0;
+  m_text_pos = 0;
+}
+
+bool search::StringFilter::update(const StringList& strings, size_t budget) {
+  if(m_needle.empty())
+    return true;
+
+  const char* text = strings.text.c_str();
+  const size_t start_pos = m_text_pos;
+  while(m_next < strings.size() && m_text_pos - start_pos < budget) {
+    const char* s = text + m_text_pos;
+    const size_t len = strlen(s);
+    if(len >= m_needle.size() && strstr(s, m_needle.c_str()))
+      m_matches.push_back((uint32_t)m_next);
+    m_text_pos += len + 1;
+    m_next++;
+  }
+  return m_next == strings.size();
+}
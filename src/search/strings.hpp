@@ -0,0 +1,137 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <stdint.h>
+#include <io/datasource.hpp>
+
+namespace search {
+
+enum StringEncoding { StringEncoding_Ascii, StringEncoding_Utf8, StringEncoding_Utf16LE, StringEncoding_Utf16BE,
+                      StringEncoding_COUNT };
+
+const char* stringEncodingName(int encoding);
+
+// appends the bytes of a string of the given encoding as utf-8, an incomplete character at the end is dropped
+void decodeString(const uint8_t* data, size_t len, int encoding, std::string& out);
+
+/*
+ * extracted strings, sorted by offset. one entry is 13 bytes, the text is only kept for filtering: the first
+ * MaxText bytes of every string lowercased, one after another and each terminated by a 0.
+ * */
+struct StringList {
+  static const size_t MaxText = 256;
+
+  std::vector<uint64_t> offsets;
+  // in bytes
+  std::vector<uint32_t> lengths;
+  std::vector<uint8_t> encodings;
+  std::string text;
+
+  size_t size() const { return offsets.size(); }
+  void clear();
+};
+
+/*
+ * finds the printable strings of a data source (like strings(1)) on a pool of worker threads.
+ *
+ * the workers take chunks one after another, a string belongs to the chunk it starts in and is followed past the
+ * chunk's end. the strings of a chunk are published by poll() once all chunks before it are done, so strings() is
+ * always sorted and complete up to progress().
+ *
+ * ascii and utf-8 are printable ascii, tabs and (for utf-8) valid sequences of U+00A0 and above. utf-16 only
+ * covers latin-1, whole bmp strings are indistinguishable from random data. a pure ascii string found with
+ * utf-8 on counts as ascii.
+ * */
+class StringExtractor {
+private:
+  struct Job {
+    std::unique_ptr<io::DataSource> source;
+    size_t size = 0;
+    size_t chunk_count = 0;
+    // StringEncoding bits
+    unsigned encodings = 0;
+    size_t min_chars = 0;
+
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<size_t> scanned{0};
+    std::atomic<size_t> found{0};
+    std::atomic<bool> cancel{false};
+    std::atomic<int> running{0};
+
+    std::mutex mutex;
+    // strings of finished chunks which can't be published yet
+    std::map<size_t, StringList> done;
+  };
+
+  std::unique_ptr<Job> m_job;
+  std::vector<std::thread> m_threads;
+  StringList m_strings;
+  size_t m_published = 0;
+  bool m_truncated = false;
+
+  static void work(Job* job);
+  void collect();
+
+  StringExtractor(const StringExtractor&);
+  void operator=(const StringExtractor&);
+
+public:
+  static const size_t ChunkSize = 4 * 1024 * 1024;
+  // the extraction stops once that many strings were found
+  static const size_t MaxStrings = 32 * 1024 * 1024;
+
+  StringExtractor() {}
+  ~StringExtractor() { cancel(); }
+
+  // extracts the strings of at least min_chars characters in the encodings (1 << StringEncoding bits) from
+  // source, which is owned from now on. a running extraction is cancelled first and the old strings are dropped
+  void start(std::unique_ptr<io::DataSource> source, unsigned encodings, size_t min_chars);
+  // stops the workers and waits for them, the strings found so far are kept
+  void cancel();
+  // cancels and forgets the strings
+  void clear();
+  // has to be called regularly (every frame), publishes new strings. returns true once an extraction has run to
+  // its end
+  bool poll();
+
+  bool isRunning() const { return m_job != nullptr; }
+  // 0..1
+  float progress() const;
+  // true if the extraction stopped at MaxStrings
+  bool truncated() const { return m_truncated; }
+
+  const StringList& strings() const { return m_strings; }
+};
+
+/*
+ * case insensitive substring filter over a growing StringList, it works through the strings a limited number of
+ * text bytes at a time so a big list doesn't stall a frame.
+ * */
+class StringFilter {
+private:
+  std::string m_needle;
+  std::vector<uint32_t> m_matches;
+  // the next string to check and where its text starts
+  size_t m_next = 0;
+  size_t m_text_pos = 0;
+
+public:
+  // sets the filter text, the matches are found again if it changed
+  void setNeedle(const std::string& needle);
+  // forgets the matches, for a new list
+  void reset();
+  // checks strings until about budget bytes of text were looked at, returns true if all strings were checked
+  bool update(const StringList& strings, size_t budget);
+
+  bool empty() const { return m_needle.empty(); }
+  // indices of the matching strings, in order
+  const std::vector<uint32_t>& matches() const { return m_matches; }
+};
+
+}
@@ -0,0 +1,79 @@
+#include "xor.hpp"
+#include "scanner.hpp"
+#include <algorithm>
+
+const size_t search::XorMatcher::MaxKeyLength;
+
+// differences computed at once
+static const size_t DiffBlock = 4096;
+
+bool search::XorMatcher::setup(const std::vector<uint8_t>& plain, size_t max_key_length) {
+  m_plain = plain;
+  m_differences.clear();
+
+  // one or two differences would match almost everywhere
+  for(size_t n = 1; n <= std::min(max_key_length, MaxKeyLength) && n + 2 <= plain.size(); n++) {
+    std::vector<uint8_t> diff(plain.size() - n);
+    for(size_t i = 0; i < diff.size(); i++)
+      diff[i] = plain[i] ^ plain[i + n];
+    m_differences.emplace_back();
+    m_differences.back().assign(diff.data(), diff.size());
+  }
+  return !m_differences.empty();
+}
+
+void search::XorMatcher::scan(const uint8_t* data, size_t len, size_t count, size_t base,
+                              std::vector<Hit>& hits) const {
+  const size_t size = m_plain.size();
+  if(len < size)
+    return;
+  // a match has to start before end
+  const size_t end = std::min(count, len - size + 1);
+
+  std::vector<Hit> found;
+  uint8_t diff[DiffBlock + 256];
+  for(size_t n = 1; n <= m_differences.size(); n++) {
+    const Pattern& pattern = m_differences[n - 1];
+    const size_t overlap = pattern.size() - 1;
+    const size_t block = std::max(DiffBlock, overlap + 1);
+    std::vector<uint8_t> big;
+    uint8_t* buf = diff;
+    if(block + overlap > sizeof(diff)) {
+      big.resize(block + overlap);
+      buf = big.data();
+    }
+
+    const size_t first = found.size();
+    for(size_t pos = 0; pos < end; pos += block) {
+      const size_t starts = std::min(block, end - pos);
+      // the differences of all bytes a match starting in [pos, pos + starts) covers
+      const size_t m = starts + overlap;
+      for(size_t i = 0; i < m; i++)
+        buf[i] = data[pos + i] ^ data[pos + i + n];
+      search::scan(pattern, buf, m, base + pos, found);
+    }
+    for(size_t i = first; i < found.size(); i++) {
+      found[i].length = (uint32_t)size;
+      found[i].tag = (uint32_t)n;
+    }
+  }
+
+  // shorter key lengths come first for the same offset, a key of length n also repeats every 2n bytes
+  std::stable_sort(found.begin(), found.end(), [](const Hit& a, const Hit& b) { return a.offset < b.offset; });
+  found.erase(std::unique(found.begin(), found.end(), [](const Hit& a, const Hit& b) { return a.offset == b.offset; }),
+              found.end());
+  hits.insert(hits.end(), found.begin(), found.end());
+}
+
+std::string search::XorMatcher::key(const Hit& hit, const uint8_t* matched) const {
+  static const char* digits = "0123456789ABCDEF";
+  std::string key;
+  for(size_t i = 0; i < hit.tag && i < m_plain.size(); i++) {
+    const uint8_t k = matched[i] ^ m_plain[i];
+    if(i)
+      key += ' ';
+    key += digits[k >> 4];
+    key += digits[k & 15];
+  }
+  return key;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "matcher.hpp"
+#include "pattern.hpp"
+
+namespace search {
+
+/*
+ * finds a plaintext xored with any key of up to a few bytes, repeating.
+ *
+ * with a key of length n the xor of bytes n apart doesn't depend on the key: (p[i] ^ k) ^ (p[i + n] ^ k) is
+ * p[i] ^ p[i + n]. so the data is turned into those differences (a block at a time, so it stays in the L1 cache)
+ * and the differences of the plaintext are searched in it with the normal pattern scanner, which finds all 256
+ * single byte keys (or 256^n keys) at once. the key is the data xored with the plaintext at a hit.
+ *
+ * a match found with several key lengths is only reported with the shortest. the tag of a hit is its key length.
+ * */
+class XorMatcher : public Matcher {
+private:
+  std::vector<uint8_t> m_plain;
+  // differences of the plaintext for every key length, index 0 is key length 1
+  std::vector<Pattern> m_differences;
+
+public:
+  static const size_t MaxKeyLength = 16;
+
+  // the plaintext needs at least 2 bytes more than the key, shorter key lengths are still searched. false if
+  // not even a single byte key fits
+  bool setup(const std::vector<uint8_t>& plain, size_t max_key_length);
+
+  size_t length() const override { return m_plain.size(); }
+  void scan(const uint8_t* data, size_t len, size_t count, size_t base, std::vector<Hit>& hits) const override;
+
+  // the key of a hit as hex, matched are the bytes at the hit
+  std::string key(const Hit& hit, const uint8_t* matched) const;
+};
+
+}